@@ -37,6 +37,8 @@ namespace serialReceiverLayer
         rcFrameReceived = false;
         frameCount = 0;
         timePerFrame = 0;
+        framePosition = 0;
+        frameStartTime = 0;
 
         crc8 = new GenericCRC();
     }
@@ -46,6 +48,8 @@ namespace serialReceiverLayer
         rcFrameReceived = crsf.rcFrameReceived;
         frameCount = crsf.frameCount;
         timePerFrame = crsf.timePerFrame;
+        framePosition = crsf.framePosition;
+        frameStartTime = crsf.frameStartTime;
 
         memcpy(rxFrame.raw, crsf.rxFrame.raw, CRSF_FRAME_SIZE_MAX);
         memcpy(rcChannelsFrame.raw, crsf.rcChannelsFrame.raw, CRSF_FRAME_SIZE_MAX);
@@ -60,6 +64,8 @@ namespace serialReceiverLayer
             rcFrameReceived = crsf.rcFrameReceived;
             frameCount = crsf.frameCount;
             timePerFrame = crsf.timePerFrame;
+            framePosition = crsf.framePosition;
+            frameStartTime = crsf.frameStartTime;
 
             memcpy(rxFrame.raw, crsf.rxFrame.raw, CRSF_FRAME_SIZE_MAX);
             memcpy(rcChannelsFrame.raw, crsf.rcChannelsFrame.raw, CRSF_FRAME_SIZE_MAX);
@@ -81,6 +87,8 @@ namespace serialReceiverLayer
         rcFrameReceived = false;
         frameCount = 0;
         timePerFrame = 0;
+        framePosition = 0;
+        frameStartTime = 0;
 
         memset(rxFrame.raw, 0, CRSF_FRAME_SIZE_MAX);
         memset(rcChannelsFrame.raw, 0, CRSF_FRAME_SIZE_MAX);
@@ -104,8 +112,6 @@ namespace serialReceiverLayer
 
     bool CRSF::receiveFrames(uint8_t rxByte)
     {
-        static uint8_t framePosition = 0;
-        static uint32_t frameStartTime = 0;
         const uint32_t currentTime = micros();
 
         /* Reset the frame position if the frame time has expired. */
@@ -124,6 +130,16 @@ namespace serialReceiverLayer
             frameStartTime = currentTime;
         }
 
+        /* Drop a frame length that can not hold the type and the CRC, or does not fit the buffer. */
+        /* The CRC would run past the buffer, and a frame shorter than the bytes already received would never end. */
+        if (framePosition == 2 && (rxFrame.frame.frameLength < CRSF_FRAME_LENGTH_TYPE_CRC ||
+                                   rxFrame.frame.frameLength > CRSF_FRAME_SIZE_MAX - CRSF_FRAME_LENGTH_ADDRESS - CRSF_FRAME_LENGTH_FRAMELENGTH))
+        {
+            memset(rxFrame.raw, 0, CRSF_FRAME_SIZE_MAX);
+            framePosition = 0;
+            frameStartTime = currentTime;
+        }
+
         /* Assume the full frame lenthg is 5 bytes until the frame length byte is received. */
         const int fullFrameLength = framePosition < 3 ? 5 : min(rxFrame.frame.frameLength + CRSF_FRAME_LENGTH_ADDRESS + CRSF_FRAME_LENGTH_FRAMELENGTH, (int)CRSF_FRAME_SIZE_MAX);
 
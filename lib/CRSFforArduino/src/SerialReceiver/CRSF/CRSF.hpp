@@ -70,6 +70,8 @@ namespace serialReceiverLayer
         bool rcFrameReceived;
         uint16_t frameCount;
         uint32_t timePerFrame;
+        uint8_t framePosition;   // Per receiver, both receivers of the timer decode at the same time.
+        uint32_t frameStartTime;
         crsfProtocol::frame_t rxFrame;
         crsfProtocol::frame_t rcChannelsFrame;
         link_statistics_t linkStatistics;
@@ -294,6 +294,7 @@ void Audio::setDefaults() {
     m_f_tts = false;
     m_f_firstCall = true;        // InitSequence for processWebstream and processLocalFile
     m_f_firstCurTimeCall = true; // InitSequence for computeAudioTime
+    m_f_indexHit = false;
     m_f_firstM3U8call = true;    // InitSequence for parsePlaylist_M3U8
     m_f_firstPlayCall = true;    // InitSequence for playAudioData
 //    m_f_running = false;       // already done in stopSong
@@ -334,6 +335,7 @@ void Audio::setDefaults() {
     m_ID3Size = 0;
     m_haveNewFilePos = 0;
     m_validSamples = 0;
+    m_f_outBuffProcessed = false;
     m_M4A_chConfig = 0;
     m_M4A_objectType = 0;
     m_M4A_sampleRate = 0;
@@ -851,6 +853,7 @@ bool Audio::connecttoFS(fs::FS& fs, const char* path, int32_t fileStartPos) {
     audiofile = fs.open(audioPath);
     m_dataMode = AUDIO_LOCALFILE;
     m_fileSize = audiofile.size();
+    m_f_indexHit = findIndexEntry(audioPath, m_fileSize, (uint32_t)audiofile.getLastWrite()) && m_indexEntry.codec == codec;
 
     res = initializeDecoder(codec);
     m_codec = codec;
@@ -863,6 +866,154 @@ exit:
     return res;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t Audio::indexPathHash(const char* path) { // FNV-1a, "a.mp3" and "/a.mp3" give the same hash
+    uint32_t hash = 2166136261UL;
+    if(path[0] != '/') {hash ^= '/'; hash *= 16777619UL;}
+    for(; *path; path++) {hash ^= (uint8_t)*path; hash *= 16777619UL;}
+    return hash;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::findIndexEntry(const char* path, uint32_t fileSize, uint32_t lastWrite) {
+    if(m_headerIndex.empty()) return false;
+    uint32_t hash = indexPathHash(path);
+    for(auto& e : m_headerIndex) {
+        if(e.pathHash != hash) continue;
+        if(e.fileSize != fileSize || e.lastWrite != lastWrite) return false; // file was replaced, parse the header as usual
+        m_indexEntry = e;
+        return true;
+    }
+    return false;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::indexMP3Header(File& file, headerIndex_t& e) {
+    uint8_t  h[10];
+    uint32_t pos = 0;
+    while(true) { // skip all ID3v2 tags, the same as read_ID3_Header()
+        if(!file.seek(pos) || file.read(h, 10) != 10) return false;
+        if(h[0] != 'I' || h[1] != 'D' || h[2] != '3') break;
+        pos += bigEndian(h + 6, 4, 7) + 10;   // synchsafe size + header
+        if(h[5] & 0x10) pos += 10;            // footer present
+        if(pos >= e.fileSize) return false;
+    }
+    e.audioDataStart = pos;
+    e.audioDataSize = e.fileSize - pos;
+
+    // first MPEG 1/2/2.5 layer III frame header within 4 KB, otherwise the decoder finds the sync word itself
+    static const uint16_t brMPEG1[15] = {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320};
+    static const uint16_t brMPEG2[15] = {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160};
+    static const uint32_t srMPEG1[3]  = {44100, 48000, 32000};
+    uint8_t buf[256];
+    for(uint32_t blk = pos; blk < pos + 4096 && blk + 4 <= e.fileSize; blk += sizeof(buf) - 3) {
+        if(!file.seek(blk)) return true;
+        int32_t n = file.read(buf, sizeof(buf));
+        for(int32_t i = 0; i + 3 < n; i++) {
+            uint8_t* fh = buf + i;
+            if(fh[0] != 0xFF || (fh[1] & 0xE0) != 0xE0) continue;
+            uint8_t version = (fh[1] >> 3) & 0x03; // 0: MPEG2.5, 2: MPEG2, 3: MPEG1
+            uint8_t layer   = (fh[1] >> 1) & 0x03; // 1: layer III
+            uint8_t brIdx   = fh[2] >> 4;
+            uint8_t srIdx   = (fh[2] >> 2) & 0x03;
+            if(version == 1 || layer != 1 || brIdx == 0 || brIdx == 15 || srIdx == 3) continue;
+            e.audioDataStart = blk + i;
+            e.audioDataSize = e.fileSize - e.audioDataStart;
+            e.bitRate = (version == 3 ? brMPEG1[brIdx] : brMPEG2[brIdx]) * 1000;
+            e.sampleRate = srMPEG1[srIdx] >> (version == 3 ? 0 : version == 2 ? 1 : 2);
+            e.channels = ((fh[3] >> 6) == 3) ? 1 : 2;
+            e.bitsPerSample = 16;
+            e.duration = (uint64_t)e.audioDataSize * 8 / e.bitRate; // exact for CBR, a VBR file is re-estimated while playing
+            return true;
+        }
+        if(n < (int32_t)sizeof(buf)) break;
+    }
+    return true;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::indexWAVHeader(File& file, headerIndex_t& e) {
+    uint8_t c[24];
+    if(file.read(c, 12) != 12 || memcmp(c, "RIFF", 4) || memcmp(c + 8, "WAVE", 4)) return false;
+    uint32_t pos = 12;
+    bool     fmtFound = false;
+    while(pos + 8 <= e.fileSize) { // walk the chunks up to "data"
+        if(!file.seek(pos) || file.read(c, 8) != 8) return false;
+        uint32_t cs = c[4] | (c[5] << 8) | (c[6] << 16) | ((uint32_t)c[7] << 24);
+        if(!memcmp(c, "fmt ", 4)) {
+            if(cs < 16 || file.read(c + 8, 16) != 16) return false;
+            uint16_t fc  = c[8] | (c[9] << 8);
+            uint16_t nic = c[10] | (c[11] << 8);
+            uint32_t sr  = c[12] | (c[13] << 8) | (c[14] << 16) | ((uint32_t)c[15] << 24);
+            uint16_t bps = c[22] | (c[23] << 8);
+            if(fc != 1 || (nic != 1 && nic != 2) || (bps != 8 && bps != 16) || sr == 0) return false; // read_WAV_Header() rejects these too
+            e.channels = nic;
+            e.sampleRate = sr;
+            e.bitsPerSample = bps;
+            e.bitRate = nic * sr * bps;
+            fmtFound = true;
+        }
+        else if(!memcmp(c, "data", 4)) {
+            if(!fmtFound) return false;
+            e.audioDataStart = pos + 8;
+            e.audioDataSize = min(cs, e.fileSize - e.audioDataStart);
+            e.duration = e.audioDataSize / (e.sampleRate * e.channels * (e.bitsPerSample / 8));
+            return true;
+        }
+        pos += 8 + cs + (cs & 1); // chunks are word aligned
+    }
+    return false;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::indexAudioFile(fs::FS& fs, const char* path) {
+    if(!path) return false;
+    headerIndex_t e = {};
+    if(endsWith(path, ".mp3")) e.codec = CODEC_MP3;
+    if(endsWith(path, ".wav")) e.codec = CODEC_WAV;
+    if(e.codec == CODEC_NONE) return false; // other formats are parsed while playing
+
+    File file = fs.open(path);
+    if(!file) return false;
+    e.pathHash = indexPathHash(path);
+    e.fileSize = file.size();
+    e.lastWrite = (uint32_t)file.getLastWrite(); // from the directory entry, no extra read
+    bool res = (e.codec == CODEC_MP3) ? indexMP3Header(file, e) : indexWAVHeader(file, e);
+    file.close();
+    if(!res) {log_w("no header index for %s", path); return false;}
+
+    for(auto& i : m_headerIndex) {
+        if(i.pathHash == e.pathHash) {i = e; return true;} // update
+    }
+    m_headerIndex.push_back(e);
+    return true;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::loadHeaderIndex(fs::FS& fs, const char* indexPath) {
+    clearHeaderIndex();
+    if(!indexPath || !fs.exists(indexPath)) return false;
+    File file = fs.open(indexPath);
+    if(!file) return false;
+    uint32_t hdr[2] = {0}; // magic, number of entries
+    bool res = file.read((uint8_t*)hdr, sizeof(hdr)) == sizeof(hdr) && hdr[0] == m_headerIndexMagic &&
+               file.size() == sizeof(hdr) + hdr[1] * sizeof(headerIndex_t);
+    if(res && hdr[1]) {
+        m_headerIndex.resize(hdr[1]);
+        res = file.read((uint8_t*)m_headerIndex.data(), hdr[1] * sizeof(headerIndex_t)) == hdr[1] * sizeof(headerIndex_t);
+    }
+    file.close();
+    if(!res) {clearHeaderIndex(); log_w("header index %s is invalid", indexPath);}
+    return res;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::saveHeaderIndex(fs::FS& fs, const char* indexPath) {
+    if(!indexPath) return false;
+    File file = fs.open(indexPath, FILE_WRITE);
+    if(!file) return false;
+    uint32_t hdr[2] = {m_headerIndexMagic, (uint32_t)m_headerIndex.size()};
+    size_t   len = m_headerIndex.size() * sizeof(headerIndex_t);
+    bool res = file.write((const uint8_t*)hdr, sizeof(hdr)) == sizeof(hdr);
+    if(res && len) res = file.write((const uint8_t*)m_headerIndex.data(), len) == len;
+    file.close();
+    if(!res) fs.remove(indexPath); // never leave a truncated index behind
+    return res;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 bool Audio::connecttospeech(const char* speech, const char* lang) {
     xSemaphoreTakeRecursive(mutex_playAudioData, 0.3 * configTICK_RATE_HZ);
 
@@ -1368,7 +1519,9 @@ int Audio::read_FLAC_Header(uint8_t* data, size_t len) {
         m_controlCounter = FLAC_OKAY;
         m_audioDataStart = headerSize;
         m_audioDataSize = m_contentlength - m_audioDataStart;
+#if AUDIO_CODEC_FLAC
         FLACSetRawBlockParams(m_flacNumChannels, m_flacSampleRate, m_flacBitsPerSample, m_flacTotalSamplesInStream, m_audioDataSize);
+#endif
         if(picLen) {
             size_t pos = audiofile.position();
             if(audio_id3image) audio_id3image(audiofile, picPos, picLen);
@@ -2211,6 +2364,7 @@ uint32_t Audio::stopSong() {
         }
         memset(m_filterBuff, 0, sizeof(m_filterBuff)); // Clear FilterBuffer
         m_validSamples = 0;
+        m_f_outBuffProcessed = false;
         m_audioCurrentTime = 0;
         m_audioFileDuration = 0;
         m_codec = CODEC_NONE;
@@ -2228,6 +2382,7 @@ bool Audio::pauseResume() {
         if(!m_f_running) {
             memset(m_outBuff, 0, m_outbuffSize * sizeof(int16_t)); // Clear OutputBuffer
             m_validSamples = 0;
+            m_f_outBuffProcessed = false;
         }
     }
     xSemaphoreGive(mutex_audioTask);
@@ -2240,12 +2395,16 @@ void Audio::playChunk() {
     static uint16_t count = 0;
     size_t i2s_bytesConsumed = 0;
     int16_t* sample[2] = {0};
-    int16_t* s2;
-    int sampleSize = 4; // 2 bytes per sample (int16_t) * 2 channels
+    int sampleSize = m_f_i2sMono ? 2 : 4; // 2 bytes per sample (int16_t) * 2 channels, or 1 channel in mono slots
     esp_err_t err = ESP_OK;
     int i= 0;
 
-    if(count > 0) goto i2swrite;
+    if(count > 0 || m_f_outBuffProcessed) goto i2swrite;
+
+    if(m_f_i2sMono){ // the slots duplicate the samples, no copy to stereo
+        for(int k = 0; k < m_validSamples; k++) processSample(m_outBuff + k);
+        goto i2swrite;
+    }
 
     if(getChannels() == 1){
         for (int i = m_validSamples - 1; i >= 0; --i) {
@@ -2260,26 +2419,7 @@ void Audio::playChunk() {
 
     while(validSamples) {
         *sample = m_outBuff + i;
-        computeVUlevel(*sample);
-
-        //---------- Filterchain, can commented out if not used-------------
-        {
-            if(m_corr > 1) {
-                s2 = *sample;
-                s2[LEFTCHANNEL] /= m_corr;
-                s2[RIGHTCHANNEL] /= m_corr;
-            }
-            IIR_filterChain0(*sample);
-            IIR_filterChain1(*sample);
-            IIR_filterChain2(*sample);
-        }
-        //------------------------------------------------------------------
-        if(m_f_forceMono && m_channels == 2){
-            int32_t xy = ((*sample)[RIGHTCHANNEL] + (*sample)[LEFTCHANNEL]) / 2;
-            (*sample)[RIGHTCHANNEL] = (int16_t)xy;
-            (*sample)[LEFTCHANNEL]  = (int16_t)xy;
-        }
-        Gain(*sample);
+        processFrame(*sample);
         i += 2;
         validSamples -= 1;
     }
@@ -2303,7 +2443,7 @@ i2swrite:
     m_validSamples -= i2s_bytesConsumed / sampleSize;
     count += i2s_bytesConsumed / 2;
     if(m_validSamples < 0) { m_validSamples = 0; }
-    if(m_validSamples == 0) { count = 0; }
+    if(m_validSamples == 0) { count = 0; m_f_outBuffProcessed = false; }
 
 // ---- statistics, bytes written to I2S (every 10s)
     // static int cnt = 0;
@@ -2327,6 +2467,70 @@ exit:
     else log_e("i2s err %i", err);
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::processFrame(int16_t sample[2]) { // one stereo frame: VU, filterchain, mono, volume
+    computeVUlevel(sample);
+
+    //---------- Filterchain, can commented out if not used-------------
+    {
+        if(m_corr > 1) {
+            sample[LEFTCHANNEL] /= m_corr;
+            sample[RIGHTCHANNEL] /= m_corr;
+        }
+        IIR_filterChain0(sample);
+        IIR_filterChain1(sample);
+        IIR_filterChain2(sample);
+    }
+    //------------------------------------------------------------------
+    if(m_f_forceMono && m_channels == 2){
+        int32_t xy = (sample[RIGHTCHANNEL] + sample[LEFTCHANNEL]) / 2;
+        sample[RIGHTCHANNEL] = (int16_t)xy;
+        sample[LEFTCHANNEL]  = (int16_t)xy;
+    }
+    Gain(sample);
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::processSample(int16_t* sample) { // one mono sample, as the left channel of a frame that holds it twice
+    int16_t frame[2] = {*sample, *sample};
+    processFrame(frame);
+    *sample = frame[LEFTCHANNEL];
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+size_t Audio::decodePCM(uint8_t* data, size_t len) { // WAV, returns the number of bytes consumed
+
+    uint8_t channels  = getChannels();
+    uint8_t frameSize = channels * getBitsPerSample() / 8;
+
+    if(m_audioDataSize > m_sumBytesDecoded && len > m_audioDataSize - m_sumBytesDecoded) {
+        len = m_audioDataSize - m_sumBytesDecoded; // last block, InBuff may hold whatever follows the data chunk
+    }
+    size_t bytes = len - len % frameSize;      // whole frames only, an incomplete last frame is dropped
+    if(bytes == 0) return len;
+
+    if(getBitsPerSample() == 8) { // unsigned 8 bit, one byte per sample and channel
+        for(size_t i = 0; i < bytes; i++) m_outBuff[i] = ((int16_t)data[i] - 128) << 8;
+        m_validSamples = bytes / channels;     // playChunk() doubles mono samples
+    }
+    else if((channels == 1 && !m_f_i2sMono) || ((uintptr_t)data & 1) || audio_process_i2s) {
+        memcpy(m_outBuff, data, bytes);
+        m_validSamples = bytes / frameSize;
+    }
+    else { // 16 bit stereo, or mono into mono slots: filter in place and let the I2S driver copy straight from InBuff
+        int16_t* s = (int16_t*)data;
+        if(channels == 1) for(size_t i = 0; i < bytes / 2; i++) processSample(s + i);
+        else              for(size_t i = 0; i < bytes / 4; i++) processFrame(s + 2 * i);
+        size_t    written = 0;
+        esp_err_t err = i2s_channel_write(m_i2s_tx_handle, data, bytes, &written, 10);
+        if(!(err == ESP_OK || err == ESP_ERR_TIMEOUT)) log_e("i2s err %i", err);
+        written -= written % frameSize;
+        if(written < bytes) { // DMA is full, playChunk() sends the rest
+            memcpy(m_outBuff, data + written, bytes - written);
+            m_validSamples = (bytes - written) / frameSize;
+            m_f_outBuffProcessed = true;
+        }
+    }
+    return len;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Audio::loop() {
     if(!m_f_running) return;
 
@@ -3099,6 +3303,20 @@ void Audio::processLocalFile() {
         if(m_codec == CODEC_M4A) seek_m4a_ilst(); // looking for metadata
         audiofile.seek(pos);
         m_audioDataSize = audiofile.size();
+        if(m_f_indexHit) { // header known from the index, start at the audio data
+            m_contentlength = m_fileSize;
+            m_audioDataStart = m_indexEntry.audioDataStart;
+            m_audioDataSize = m_indexEntry.audioDataSize;
+            if(m_codec == CODEC_WAV) {
+                setBitsPerSample(m_indexEntry.bitsPerSample);
+                setChannels(m_indexEntry.channels);
+                setSampleRate(m_indexEntry.sampleRate);
+                setBitrate(m_indexEntry.bitRate);
+            }
+            audiofile.seek(m_audioDataStart);
+            m_controlCounter = 100;
+            AUDIO_INFO("header from index, Audio-Length: %u", m_audioDataSize);
+        }
         if(m_resumeFilePos == 0) m_resumeFilePos = -1; // parkposition
         return;
     }
@@ -3142,10 +3360,18 @@ void Audio::processLocalFile() {
 
         if(m_codec == CODEC_M4A) {m_resumeFilePos = m4a_correctResumeFilePos(m_resumeFilePos);   if(m_resumeFilePos == -1) goto exit;}
         if(m_codec == CODEC_WAV) {while((m_resumeFilePos % 4) != 0){m_resumeFilePos++; if(m_resumeFilePos >= m_fileSize)   goto exit;}}  // must divisible by four
+#if AUDIO_CODEC_FLAC
         if(m_codec == CODEC_FLAC) {m_resumeFilePos = flac_correctResumeFilePos(m_resumeFilePos); if(m_resumeFilePos == -1) goto exit; FLACDecoderReset();}
+#endif
+#if AUDIO_CODEC_MP3
         if(m_codec == CODEC_MP3) { m_resumeFilePos = mp3_correctResumeFilePos(m_resumeFilePos);  if(m_resumeFilePos == -1) goto exit; MP3Decoder_ClearBuffer();}
+#endif
+#if AUDIO_CODEC_VORBIS
         if(m_codec == CODEC_VORBIS){m_resumeFilePos = ogg_correctResumeFilePos(m_resumeFilePos); if(m_resumeFilePos == -1) goto exit; VORBISDecoder_ClearBuffers();}
+#endif
+#if AUDIO_CODEC_OPUS
         if(m_codec == CODEC_OPUS){m_resumeFilePos = ogg_correctResumeFilePos(m_resumeFilePos);   if(m_resumeFilePos == -1) goto exit; OPUSDecoder_ClearBuffers();}
+#endif
 
         m_f_lockInBuffer = true;                          // lock the buffer, the InBuffer must not be re-entered in playAudioData()
             while(m_f_audioTaskIsDecoding) vTaskDelay(1); // We can't reset the InBuffer while the decoding is in progress
@@ -3153,7 +3379,8 @@ void Audio::processLocalFile() {
             InBuff.resetBuffer();
             m_sumBytesDecoded = m_haveNewFilePos = m_resumeFilePos;
             m_resumeFilePos = -1;
-            if(m_codec == CODEC_MP3) MP3Decoder_ClearBuffer();
+            const AudioDecoder_t* dec = findDecoder(m_codec);
+            if(dec && dec->clearBuffers) dec->clearBuffers();
         m_f_lockInBuffer = false;
     }
 
@@ -3165,12 +3392,8 @@ exit:
         if(audiofile) afn = strdup(audiofile.name()); // store temporary the name
         stopSong();
 
-        if(m_codec == CODEC_MP3) MP3Decoder_FreeBuffers();
-        if(m_codec == CODEC_AAC) AACDecoder_FreeBuffers();
-        if(m_codec == CODEC_M4A) AACDecoder_FreeBuffers();
-        if(m_codec == CODEC_FLAC) FLACDecoder_FreeBuffers();
-        if(m_codec == CODEC_OPUS) OPUSDecoder_FreeBuffers();
-        if(m_codec == CODEC_VORBIS) VORBISDecoder_FreeBuffers();
+        const AudioDecoder_t* dec = findDecoder(m_codec);
+        if(dec && !dec->keepBuffers) dec->freeBuffers(); // e.g. the MP3 arena stays, the next clip reuses it
 
         m_audioCurrentTime = 0;
         m_audioFileDuration = 0;
@@ -3329,12 +3552,7 @@ void Audio::processWebFile() {
 
         m_f_running = false;
         m_streamType = ST_NONE;
-        if(m_codec == CODEC_MP3) MP3Decoder_FreeBuffers();
-        if(m_codec == CODEC_AAC) AACDecoder_FreeBuffers();
-        if(m_codec == CODEC_M4A) AACDecoder_FreeBuffers();
-        if(m_codec == CODEC_FLAC) FLACDecoder_FreeBuffers();
-        if(m_codec == CODEC_OPUS) OPUSDecoder_FreeBuffers();
-        if(m_codec == CODEC_VORBIS) VORBISDecoder_FreeBuffers();
+        if(findDecoder(m_codec)) findDecoder(m_codec)->freeBuffers();
         m_codec = CODEC_NONE;
         if(m_f_tts) {
             AUDIO_INFO("End of speech \"%s\"", m_speechtxt);
@@ -3902,86 +4120,34 @@ lastToDo:
 bool Audio::initializeDecoder(uint8_t codec) {
     uint32_t gfH = 0;
     uint32_t hWM = 0;
+    const AudioDecoder_t* dec = NULL;
     switch(codec) {
-        case CODEC_MP3:
-            if(!MP3Decoder_IsInit()){
-                if(!MP3Decoder_AllocateBuffers()) {
-                    AUDIO_INFO("The MP3Decoder could not be initialized");
-                    goto exit;
-                }
-                gfH = ESP.getFreeHeap();
-                hWM = uxTaskGetStackHighWaterMark(NULL);
-                AUDIO_INFO("MP3Decoder has been initialized, free Heap: %lu bytes , free stack %lu DWORDs", (long unsigned int)gfH, (long unsigned int)hWM);
-                InBuff.changeMaxBlockSize(m_frameSizeMP3);
-            }
-            break;
-        case CODEC_AAC:
-            if(!AACDecoder_IsInit()) {
-                if(!AACDecoder_AllocateBuffers()) {
-                    AUDIO_INFO("The AACDecoder could not be initialized");
-                    goto exit;
-                }
-                gfH = ESP.getFreeHeap();
-                hWM = uxTaskGetStackHighWaterMark(NULL);
-                AUDIO_INFO("AACDecoder has been initialized, free Heap: %lu bytes , free stack %lu DWORDs", (long unsigned int)gfH, (long unsigned int)hWM);
-                InBuff.changeMaxBlockSize(m_frameSizeAAC);
-            }
-            break;
-        case CODEC_M4A:
-            if(!AACDecoder_IsInit()) {
-                if(!AACDecoder_AllocateBuffers()) {
-                    AUDIO_INFO("The AACDecoder could not be initialized");
-                    goto exit;
-                }
-                gfH = ESP.getFreeHeap();
-                hWM = uxTaskGetStackHighWaterMark(NULL);
-                AUDIO_INFO("AACDecoder has been initialized, free Heap: %lu bytes , free stack %lu DWORDs", (long unsigned int)gfH, (long unsigned int)hWM);
-                InBuff.changeMaxBlockSize(m_frameSizeAAC);
-            }
-            break;
-        case CODEC_FLAC:
-            if(!psramFound()) {
-                AUDIO_INFO("FLAC works only with PSRAM!");
-                goto exit;
-            }
-            if(!FLACDecoder_AllocateBuffers()) {
-                AUDIO_INFO("The FLACDecoder could not be initialized");
-                goto exit;
-            }
-            gfH = ESP.getFreeHeap();
-            hWM = uxTaskGetStackHighWaterMark(NULL);
-            InBuff.changeMaxBlockSize(m_frameSizeFLAC);
-            AUDIO_INFO("FLACDecoder has been initialized, free Heap: %lu bytes , free stack %lu DWORDs", (long unsigned int)gfH, (long unsigned int)hWM);
-            break;
-        case CODEC_OPUS:
-            if(!OPUSDecoder_AllocateBuffers()) {
-                AUDIO_INFO("The OPUSDecoder could not be initialized");
-                goto exit;
-            }
-            gfH = ESP.getFreeHeap();
-            hWM = uxTaskGetStackHighWaterMark(NULL);
-            AUDIO_INFO("OPUSDecoder has been initialized, free Heap: %lu bytes , free stack %lu DWORDs", (long unsigned int)gfH, (long unsigned int)hWM);
-            InBuff.changeMaxBlockSize(m_frameSizeOPUS);
-            break;
-        case CODEC_VORBIS:
-            if(!psramFound()) {
-                AUDIO_INFO("VORBIS works only with PSRAM!");
-                goto exit;
-            }
-            if(!VORBISDecoder_AllocateBuffers()) {
-                AUDIO_INFO("The VORBISDecoder could not be initialized");
-                goto exit;
-            }
-            gfH = ESP.getFreeHeap();
-            hWM = uxTaskGetStackHighWaterMark(NULL);
-            AUDIO_INFO("VORBISDecoder has been initialized, free Heap: %lu bytes,  free stack %lu DWORDs", (long unsigned int)gfH, (long unsigned int)hWM);
-            InBuff.changeMaxBlockSize(m_frameSizeVORBIS);
-            break;
-        case CODEC_WAV: InBuff.changeMaxBlockSize(m_frameSizeWav); break;
-        case CODEC_OGG: // the decoder will be determined later (vorbis, flac, opus?)
-            break;
-        default: goto exit; break;
+        case CODEC_WAV: InBuff.changeMaxBlockSize(m_frameSizeWav); return true;
+        case CODEC_OGG: return true; // the decoder will be determined later (vorbis, flac, opus?)
+        default: break;
+    }
+    dec = findDecoder(codec);
+    if(!dec) {
+        AUDIO_INFO("No decoder for codec %i in this build", codec);
+        goto exit;
     }
+    if(dec->needsPSRAM && !psramFound()) {
+        AUDIO_INFO("%s works only with PSRAM!", dec->name);
+        goto exit;
+    }
+    if(dec->isInit && dec->isInit()) {
+        if(dec->clearBuffers) dec->clearBuffers(); // buffers are kept between files, start from a clean state
+    }
+    else {
+        if(!dec->allocateBuffers()) {
+            AUDIO_INFO("The %sDecoder could not be initialized", dec->name);
+            goto exit;
+        }
+        gfH = ESP.getFreeHeap();
+        hWM = uxTaskGetStackHighWaterMark(NULL);
+        AUDIO_INFO("%sDecoder has been initialized, free Heap: %lu bytes , free stack %lu DWORDs", dec->name, (long unsigned int)gfH, (long unsigned int)hWM);
+    }
+    InBuff.changeMaxBlockSize(dec->maxFrameSize);
     return true;
 
 exit:
@@ -3989,6 +4155,14 @@ exit:
     return false;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+const AudioDecoder_t* Audio::findDecoder(uint8_t codec) {
+    // audio_codecs.cpp lists only the decoders enabled in audio_codecs.h
+    for(const AudioDecoder_t* d = audioDecoders; d->name; d++) {
+        if(d->codec == codec) return d;
+    }
+    return NULL;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 // clang-format off
 bool Audio::parseContentType(char* ct) {
     enum : int { CT_NONE, CT_MP3, CT_AAC, CT_M4A, CT_WAV, CT_FLAC, CT_PLS, CT_M3U, CT_ASX, CT_M3U8, CT_TXT, CT_AACP, CT_OPUS, CT_OGG, CT_VORBIS };
@@ -4248,6 +4422,7 @@ void Audio::showCodecParams() {
     if(getBitRate()) { AUDIO_INFO("BitRate: %lu", (long unsigned int)getBitRate()); }
     else { AUDIO_INFO("BitRate: N/A"); }
 
+#if AUDIO_CODEC_AAC
     if(m_codec == CODEC_AAC) {
         uint8_t answ = AACGetFormat();
         if(answ < 3) {
@@ -4260,6 +4435,7 @@ void Audio::showCodecParams() {
             AUDIO_INFO("Spectral band replication: %s", sbr[answ]);
         }
     }
+#endif
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 int Audio::findNextSync(uint8_t* data, size_t len) {
@@ -4272,15 +4448,12 @@ int Audio::findNextSync(uint8_t* data, size_t len) {
 
     int         nextSync = 0;
     static uint32_t swnf = 0;
+    const AudioDecoder_t* dec = findDecoder(m_codec);
     if(m_codec == CODEC_WAV) {
         m_f_playing = true;
         nextSync = 0;
     }
-    if(m_codec == CODEC_MP3) {
-        nextSync = MP3FindSyncWord(data, len);
-        if(nextSync == -1) return len; // syncword not found, search next block
-    }
-    if(m_codec == CODEC_AAC) { nextSync = AACFindSyncWord(data, len); }
+#if AUDIO_CODEC_AAC
     if(m_codec == CODEC_M4A) {
         if(!m_M4A_chConfig)m_M4A_chConfig = 2; // guard
         if(!m_M4A_sampleRate)m_M4A_sampleRate = 44100;
@@ -4289,17 +4462,11 @@ int Audio::findNextSync(uint8_t* data, size_t len) {
         m_f_playing = true;
         nextSync = 0;
     }
-    if(m_codec == CODEC_FLAC) {
-        nextSync = FLACFindSyncWord(data, len);
-        if(nextSync == -1) return len; // OggS not found, search next block
-    }
-    if(m_codec == CODEC_OPUS) {
-        nextSync = OPUSFindSyncWord(data, len);
-        if(nextSync == -1) return len; // OggS not found, search next block
-    }
-    if(m_codec == CODEC_VORBIS) {
-        nextSync = VORBISFindSyncWord(data, len);
-        if(nextSync == -1) return len; // OggS not found, search next block
+#endif
+    if(dec && dec->findSyncWord) {
+        nextSync = dec->findSyncWord(data, len);
+        // syncword (or OggS) not found, search next block - AAC reports it below instead
+        if(nextSync == -1 && m_codec != CODEC_AAC) return len;
     }
     if(nextSync == -1) {
         if(audio_info && swnf == 0) audio_info("syncword not found");
@@ -4323,49 +4490,42 @@ int Audio::findNextSync(uint8_t* data, size_t len) {
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Audio::setDecoderItems() {
+    const AudioDecoder_t* dec = findDecoder(m_codec);
+    if(dec) {
+        setChannels(dec->getChannels());
+        setSampleRate(dec->getSampRate());
+        setBitsPerSample(dec->getBitsPerSample());
+        setBitrate(dec->getBitRate());
+    }
+#if AUDIO_CODEC_MP3
     if(m_codec == CODEC_MP3) {
-        setChannels(MP3GetChannels());
-        setSampleRate(MP3GetSampRate());
-        setBitsPerSample(MP3GetBitsPerSample());
-        setBitrate(MP3GetBitrate());
         AUDIO_INFO("MPEG-%s, Layer %s",(MP3GetVersion()==0) ? "2.5" : (MP3GetVersion()==2) ? "2" : "1", (MP3GetLayer()==1) ? "III" : (MP3GetLayer()==2) ? "II" : "I");
     }
-    if(m_codec == CODEC_AAC || m_codec == CODEC_M4A) {
-        setChannels(AACGetChannels());
-        setSampleRate(AACGetSampRate());
-        setBitsPerSample(AACGetBitsPerSample());
-        setBitrate(AACGetBitrate());
-    }
+#endif
+#if AUDIO_CODEC_FLAC
     if(m_codec == CODEC_FLAC) {
-        setChannels(FLACGetChannels());
-        setSampleRate(FLACGetSampRate());
-        setBitsPerSample(FLACGetBitsPerSample());
-        setBitrate(FLACGetBitRate());
         if(FLACGetAudioDataStart() > 0){ // only flac-ogg, native flac sets audioDataStart in readFlacHeader()
             m_audioDataStart = FLACGetAudioDataStart();
             if(getFileSize()) m_audioDataSize = getFileSize() - m_audioDataStart;
         }
     }
+#endif
+#if AUDIO_CODEC_OPUS
     if(m_codec == CODEC_OPUS) {
-        setChannels(OPUSGetChannels());
-        setSampleRate(OPUSGetSampRate());
-        setBitsPerSample(OPUSGetBitsPerSample());
-        setBitrate(OPUSGetBitRate());
         if(OPUSGetAudioDataStart() > 0){
             m_audioDataStart = OPUSGetAudioDataStart();
             if(getFileSize()) m_audioDataSize = getFileSize() - m_audioDataStart;
         }
     }
+#endif
+#if AUDIO_CODEC_VORBIS
     if(m_codec == CODEC_VORBIS) {
-        setChannels(VORBISGetChannels());
-        setSampleRate(VORBISGetSampRate());
-        setBitsPerSample(VORBISGetBitsPerSample());
-        setBitrate(VORBISGetBitRate());
         if(VORBISGetAudioDataStart() > 0){
             m_audioDataStart = VORBISGetAudioDataStart();
             if(getFileSize()) m_audioDataSize = getFileSize() - m_audioDataStart;
         }
     }
+#endif
     if(getBitsPerSample() != 8 && getBitsPerSample() != 16) {
         AUDIO_INFO("Bits per sample must be 8 or 16, found %i", getBitsPerSample());
         stopSong();
@@ -4398,15 +4558,19 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
     if(m_codec == CODEC_NONE && m_playlistFormat == FORMAT_M3U8) return 0; // can happen when the m3u8 playlist is loaded
     if(!m_f_decode_ready) return 0; // find sync first
 
-    switch(m_codec) {
-        case CODEC_WAV:  m_decodeError = 0; bytesLeft = 0; break;
-        case CODEC_MP3:  m_decodeError = MP3Decode(data, &bytesLeft, m_outBuff, 0); break;
-        case CODEC_AAC:  m_decodeError = AACDecode(data, &bytesLeft, m_outBuff); break;
-        case CODEC_M4A:  m_decodeError = AACDecode(data, &bytesLeft, m_outBuff); break;
-        case CODEC_FLAC: m_decodeError = FLACDecode(data, &bytesLeft, m_outBuff); break;
-        case CODEC_OPUS: m_decodeError = OPUSDecode(data, &bytesLeft, m_outBuff); break;
-        case CODEC_VORBIS: m_decodeError = VORBISDecode(data, &bytesLeft, m_outBuff); break;
-        default: {
+    const AudioDecoder_t* dec = NULL;
+    if(m_codec == CODEC_WAV) {
+        if(f_setDecodeParamsOnce) { // the 16 bit stereo path writes to I2S in decodePCM()
+            f_setDecodeParamsOnce = false;
+            setDecoderItems();
+            m_PlayingStartTime = millis();
+        }
+        m_decodeError = 0; bytesLeft = len - decodePCM(data, len);
+    }
+    else {
+        dec = findDecoder(m_codec);
+        if(dec) m_decodeError = dec->decode(data, &bytesLeft, m_outBuff);
+        else {
             log_e("no valid codec found codec = %d", m_codec);
             stopSong();
         }
@@ -4425,6 +4589,7 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
         //    if(m_decodeError == ERR_FLAC_BITS_PER_SAMPLE_TOO_BIG) stopSong();
         //    if(m_decodeError == ERR_FLAC_RESERVED_CHANNEL_ASSIGNMENT) stopSong();
         }
+#if AUDIO_CODEC_OPUS
         if(m_codec == CODEC_OPUS) {
             if(m_decodeError == ERR_OPUS_HYBRID_MODE_UNSUPPORTED) stopSong();
             if(m_decodeError == ERR_OPUS_SILK_MODE_UNSUPPORTED) stopSong();
@@ -4434,6 +4599,7 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
             if(m_decodeError == ERR_OPUS_INVALID_SAMPLERATE) stopSong();
             return 0;
         }
+#endif
 
         return 1; // skip one byte and seek for the next sync word
     }
@@ -4449,34 +4615,17 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
     char* st = NULL;
     std::vector<uint32_t> vec;
     switch(m_codec) {
-        case CODEC_WAV:     if(getBitsPerSample() == 16){
-                                memmove(m_outBuff, data, len); // copy len data in outbuff and set validsamples and bytesdecoded=len
-                                m_validSamples = len / (2 * getChannels());
-                            }
-                            else{
-                                for(int i = 0; i < len; i++) {
-                                    int16_t sample1 = (data[i] & 0x00FF)      - 128;
-                                    int16_t sample2 = (data[i] & 0xFF00 >> 8) - 128;
-                                    m_outBuff[i * 2 + 0] = sample1 << 8;
-                                    m_outBuff[i * 2 + 1] = sample2 << 8;
-                                }
-                                m_validSamples = len;
-                            }
-                            break;
-        case CODEC_MP3:     m_validSamples = MP3GetOutputSamps() / getChannels();
-                            break;
-        case CODEC_AAC:     m_validSamples = AACGetOutputSamps() / getChannels();
-                            static uint8_t isPS = 0;
+#if AUDIO_CODEC_AAC
+        case CODEC_AAC:     static uint8_t isPS = 0;
                             if(!isPS && AACGetParametricStereo()){ // only change 0 -> 1
                                 isPS = 1;
                                 AUDIO_INFO("Parametric Stereo");
                             }
                             else isPS = AACGetParametricStereo();
                             break;
-        case CODEC_M4A:     m_validSamples = AACGetOutputSamps() / getChannels();
-                            break;
+#endif
+#if AUDIO_CODEC_FLAC
         case CODEC_FLAC:    if(m_decodeError == FLAC_PARSE_OGG_DONE) return bytesDecoded; // nothing to play
-                            m_validSamples = FLACGetOutputSamps() / getChannels();
                             st = FLACgetStreamTitle();
                             if(st) {
                                 AUDIO_INFO(st);
@@ -4491,8 +4640,9 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
                                 if(audio_oggimage) audio_oggimage(audiofile, vec);
                             }
                             break;
+#endif
+#if AUDIO_CODEC_OPUS
         case CODEC_OPUS:    if(m_decodeError == OPUS_PARSE_OGG_DONE) return bytesDecoded; // nothing to play
-                            m_validSamples = OPUSGetOutputSamps();
                             st = OPUSgetStreamTitle();
                             if(st){
                                 AUDIO_INFO(st);
@@ -4507,8 +4657,9 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
                                 if(audio_oggimage) audio_oggimage(audiofile, vec);
                             }
                             break;
+#endif
+#if AUDIO_CODEC_VORBIS
         case CODEC_VORBIS:  if(m_decodeError == VORBIS_PARSE_OGG_DONE) return bytesDecoded; // nothing to play
-                            m_validSamples = VORBISGetOutputSamps();
                             st = VORBISgetStreamTitle();
                             if(st) {
                                 AUDIO_INFO(st);
@@ -4523,7 +4674,10 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
                                 if(audio_oggimage) audio_oggimage(audiofile, vec);
                             }
                             break;
+#endif
+        default:            break;
     }
+    if(dec) m_validSamples = dec->getOutputSamps(); // WAV: set in decodePCM()
     if(f_setDecodeParamsOnce && m_validSamples) {
         f_setDecodeParamsOnce = false;
         setDecoderItems();
@@ -4531,6 +4685,7 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
     }
 
     uint16_t bytesDecoderOut = m_validSamples;
+    if(m_codec == CODEC_WAV) bytesDecoderOut = bytesDecoded / (getChannels() * getBitsPerSample() / 8); // the direct path leaves m_validSamples at 0
     if(m_channels == 2) bytesDecoderOut /= 2;
     if(m_bitsPerSample == 16) bytesDecoderOut *= 2;
     computeAudioTime(bytesDecoded, bytesDecoderOut);
@@ -4562,17 +4717,23 @@ void Audio::computeAudioTime(uint16_t bytesDecoderIn, uint16_t bytesDecoderOut)
         deltaBytesIn = 0;
         nominalBitRate = 0;
 
+#if AUDIO_CODEC_FLAC
         if(m_codec == CODEC_FLAC && FLACGetAudioFileDuration()){
             m_audioFileDuration = FLACGetAudioFileDuration();
             nominalBitRate = (m_audioDataSize / FLACGetAudioFileDuration()) * 8;
             m_avr_bitrate = nominalBitRate;
         }
+#endif
         if(m_codec == CODEC_WAV){
             nominalBitRate = getBitRate();
             m_avr_bitrate = nominalBitRate;
             m_audioFileDuration = m_audioDataSize  / (getSampleRate() * getChannels());
             if(getBitsPerSample() == 16) m_audioFileDuration /= 2;
         }
+        if(m_codec == CODEC_MP3 && m_f_indexHit && m_indexEntry.bitRate){ // CBR assumed, corrected below if the file is VBR
+            m_avr_bitrate = m_indexEntry.bitRate;
+            m_audioFileDuration = m_indexEntry.duration;
+        }
     }
 
     sumBytesIn   += bytesDecoderIn;
@@ -4654,10 +4815,12 @@ void Audio::printDecodeError(int r) {
         }
         AUDIO_INFO("MP3 decode error %d : %s", r, e);
     }
+#if AUDIO_CODEC_AAC
     if(m_codec == CODEC_AAC || m_codec == CODEC_M4A) {
         e = AACGetErrorMessage(abs(r));
         AUDIO_INFO("AAC decode error %d : %s", r, e);
     }
+#endif
     if(m_codec == CODEC_FLAC) {
         switch(r) {
             case ERR_FLAC_NONE: e = "NONE"; break;
@@ -4849,6 +5012,7 @@ bool Audio::setFilePos(uint32_t pos) {
     if(m_codec == CODEC_AAC) return false;   // not impl. yet
     memset(m_outBuff, 0, m_outbuffSize * sizeof(int16_t));
     m_validSamples = 0;
+    m_f_outBuffProcessed = false;
     m_haveNewFilePos = pos; // used in computeAudioCurrentTime()
     if(m_dataMode == AUDIO_LOCALFILE){
         m_resumeFilePos = pos;  // used in processLocalFile()
@@ -4891,13 +5055,20 @@ void Audio::reconfigI2S(){
 
     I2Sstop(0);
 
-    if(getBitsPerSample() == 8 && getChannels() == 2) m_i2s_std_cfg.clk_cfg.sample_rate_hz = getSampleRate() * 2;
-    else m_i2s_std_cfg.clk_cfg.sample_rate_hz = getSampleRate();
+    m_i2s_std_cfg.clk_cfg.sample_rate_hz = getSampleRate();
+
+    // 16 bit mono WAV goes to I2S as it is stored, the mono slots send every sample to both channels
+#if CONFIG_IDF_TARGET_ESP32
+    m_f_i2sMono = false; // the ESP32 swaps each pair of samples in 16 bit TX mono (ESP-IDF I2S std mode), stay stereo
+#else
+    m_f_i2sMono = m_codec == CODEC_WAV && getChannels() == 1 && getBitsPerSample() == 16 && !audio_process_i2s;
+#endif
+    i2s_slot_mode_t slotMode = m_f_i2sMono ? I2S_SLOT_MODE_MONO : I2S_SLOT_MODE_STEREO;
 
-    if(!m_f_commFMT) m_i2s_std_cfg.slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO);
-    else             m_i2s_std_cfg.slot_cfg = I2S_STD_MSB_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO);
+    if(!m_f_commFMT) m_i2s_std_cfg.slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, slotMode);
+    else             m_i2s_std_cfg.slot_cfg = I2S_STD_MSB_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, slotMode);
 
-    m_i2s_std_cfg.slot_cfg.slot_mask = I2S_STD_SLOT_BOTH;
+    m_i2s_std_cfg.slot_cfg.slot_mask = I2S_STD_SLOT_BOTH; // in mono mode: the same sample in both slots
 
     i2s_channel_reconfig_std_clock(m_i2s_tx_handle, &m_i2s_std_cfg.clk_cfg);
     i2s_channel_reconfig_std_slot(m_i2s_tx_handle, &m_i2s_std_cfg.slot_cfg);
@@ -6164,6 +6335,9 @@ int32_t Audio::mp3_correctResumeFilePos(uint32_t resumeFilePos) {
         return -1; // Return -1 if sync word is not found
     };
 
+    const AudioDecoder_t* dec = findDecoder(CODEC_MP3);
+    if(!dec) return -1;
+
     uint32_t pos = resumeFilePos;
     if(pos < m_audioDataStart) pos = m_audioDataStart;
     audiofile.seek(pos);
@@ -6188,7 +6362,7 @@ int32_t Audio::mp3_correctResumeFilePos(uint32_t resumeFilePos) {
             uint32_t bitrate = ((int32_t) bitrateTab[mpegVers][layer - 1][brIdx]) * 1000;
             uint32_t samplerate = samplerateTab[mpegVers][srIdx];
         //    log_e("%02X, %02X bitrate %i, samplerate %i", syncH, syncL, bitrate, samplerate);
-            if(MP3GetBitrate() == bitrate && getSampleRate() == samplerate) break;
+            if((uint32_t)dec->getBitRate() == bitrate && getSampleRate() == samplerate) break;
         }
         pos++;
     }
@@ -21,6 +21,7 @@
 #include <atomic>
 #include <codecvt>
 #include <locale>
+#include "audio_codecs.h"
 
 #if ESP_ARDUINO_VERSION_MAJOR >= 3
 #include <NetworkClient.h>
@@ -182,6 +183,13 @@ public:
     const char *getCodecname() {return codecname[m_codec];}
     const char *getVersion() {return audioI2SVers;}
 
+    // header index: MP3 and WAV headers are parsed once, connecttoFS() then starts directly at the audio data
+    bool indexAudioFile(fs::FS &fs, const char* path);
+    bool loadHeaderIndex(fs::FS &fs, const char* indexPath);
+    bool saveHeaderIndex(fs::FS &fs, const char* indexPath);
+    void clearHeaderIndex() {m_headerIndex.clear(); m_headerIndex.shrink_to_fit();}
+    size_t headerIndexSize() {return m_headerIndex.size();}
+
 private:
 
     #ifndef ESP_ARDUINO_VERSION_VAL
@@ -233,6 +241,9 @@ private:
   void            reconfigI2S();
   bool            setBitrate(int br);
   void            playChunk();
+  void            processFrame(int16_t sample[2]);
+  void            processSample(int16_t* sample);
+  size_t          decodePCM(uint8_t* data, size_t len);
   void            computeVUlevel(int16_t sample[2]);
   void            computeLimit();
   void            Gain(int16_t* sample);
@@ -240,6 +251,7 @@ private:
   bool            parseContentType(char* ct);
   bool            parseHttpResponseHeader();
   bool            initializeDecoder(uint8_t codec);
+  const AudioDecoder_t* findDecoder(uint8_t codec);
   esp_err_t       I2Sstart(uint8_t i2s_num);
   esp_err_t       I2Sstop(uint8_t i2s_num);
   void            IIR_filterChain0(int16_t iir_in[2], bool clear = false);
@@ -585,8 +597,6 @@ private:
                  FLAC_SEEK = 6, FLAC_VORBIS = 7, FLAC_CUESHEET = 8, FLAC_PICTURE = 9, FLAC_OKAY = 100};
     enum : int { M4A_BEGIN = 0, M4A_FTYP = 1, M4A_CHK = 2, M4A_MOOV = 3, M4A_FREE = 4, M4A_TRAK = 5, M4A_MDAT = 6,
                  M4A_ILST = 7, M4A_MP4A = 8, M4A_AMRDY = 99, M4A_OKAY = 100};
-    enum : int { CODEC_NONE = 0, CODEC_WAV = 1, CODEC_MP3 = 2, CODEC_AAC = 3, CODEC_M4A = 4, CODEC_FLAC = 5,
-                 CODEC_AACP = 6, CODEC_OPUS = 7, CODEC_OGG = 8, CODEC_VORBIS = 9};
     enum : int { ST_NONE = 0, ST_WEBFILE = 1, ST_WEBSTREAM = 2};
     typedef enum { LEFTCHANNEL=0, RIGHTCHANNEL=1 } SampleIndex;
     typedef enum { LOWSHELF = 0, PEAKEQ = 1, HIFGSHELF =2 } FilterType;
@@ -604,6 +614,26 @@ private:
         int pids[4];
     } pid_array;
 
+    typedef struct _headerIndex{    // one entry per indexed file, written as is to the index file
+        uint32_t pathHash;          // FNV-1a of the path, leading '/' included
+        uint32_t fileSize;          // the entry is stale if the size or the write time has changed
+        uint32_t lastWrite;         // File::getLastWrite(), a file replaced by one of the same size has another
+        uint32_t audioDataStart;    // first byte behind all ID3 tags / the WAV data chunk header
+        uint32_t audioDataSize;
+        uint32_t sampleRate;
+        uint32_t bitRate;           // 0: unknown, determined while playing
+        uint32_t duration;          // seconds, 0: unknown
+        uint8_t  codec;
+        uint8_t  channels;
+        uint8_t  bitsPerSample;
+        uint8_t  reserved;
+    } headerIndex_t;
+    static constexpr uint32_t m_headerIndexMagic = 0x32584941; // "AIX2", bump if headerIndex_t changes
+    uint32_t        indexPathHash(const char* path);
+    bool            indexMP3Header(File& file, headerIndex_t& e);
+    bool            indexWAVHeader(File& file, headerIndex_t& e);
+    bool            findIndexEntry(const char* path, uint32_t fileSize, uint32_t lastWrite);
+
     File                  audiofile;
 #ifndef ETHERNET_IF
     WiFiClient            client;
@@ -633,13 +663,10 @@ private:
     std::vector<char*>    m_playlistContent;  // m3u8 playlist buffer
     std::vector<char*>    m_playlistURL;      // m3u8 streamURLs buffer
     std::vector<uint32_t> m_hashQueue;
+    std::vector<headerIndex_t> m_headerIndex;
+    headerIndex_t         m_indexEntry = {};  // entry of the current file, valid if m_f_indexHit
 
-    const size_t    m_frameSizeWav    = 4096;
-    const size_t    m_frameSizeMP3    = 1600;
-    const size_t    m_frameSizeAAC    = 1600;
-    const size_t    m_frameSizeFLAC   = 4096 * 4;
-    const size_t    m_frameSizeOPUS   = 1024;
-    const size_t    m_frameSizeVORBIS = 4096 * 2;
+    static constexpr size_t m_frameSizeWav    = 4096;   // the decoders take theirs from audioDecoders[]
     const size_t    m_outbuffSize     = 4096 * 2;
 
     static const uint8_t m_tsPacketSize  = 188;
@@ -720,6 +747,7 @@ private:
     bool            m_f_running = false;
     bool            m_f_firstCall = false;          // InitSequence for processWebstream and processLokalFile
     bool            m_f_firstCurTimeCall = false;   // InitSequence for computeAudioTime
+    bool            m_f_indexHit = false;           // connecttoFS() found the file in the header index
     bool            m_f_firstPlayCall = false;      // InitSequence for playAudioData
     bool            m_f_firstM3U8call = false;      // InitSequence for m3u8 parsing
     bool            m_f_ID3v1TagFound = false;      // ID3v1 tag found
@@ -742,6 +770,8 @@ private:
     bool            m_f_decode_ready = false;       // if true data for decode are ready
     bool            m_f_eof = false;                // end of file
     bool            m_f_lockInBuffer = false;       // lock inBuffer for manipulation
+    bool            m_f_outBuffProcessed = false;   // m_outBuff holds filtered samples, playChunk() only writes them
+    bool            m_f_i2sMono = false;            // I2S slots in mono mode, one int16_t per frame goes to both channels
     bool            m_f_audioTaskIsDecoding = false;
     bool            m_f_acceptRanges = false;
     uint8_t         m_f_channelEnabled = 3;         //
@@ -5,6 +5,9 @@
  *  Updated on: 14.01.2025
 */
 
+#include "../audio_codecs.h"
+#if AUDIO_CODEC_AAC
+
 #include "Arduino.h"
 #include "aac_decoder.h"
 #include <stdbool.h>
@@ -187,3 +190,4 @@ const char* AACGetErrorMessage(int8_t err){
     return NeAACDecGetErrorMessage(abs(err));
 }
 //----------------------------------------------------------------------------------------------------------------------
+#endif // AUDIO_CODEC_AAC
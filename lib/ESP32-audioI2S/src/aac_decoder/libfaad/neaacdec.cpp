@@ -27,6 +27,9 @@
 **
 ** $Id: bits.c,v 1.44 2007/11/01 12:33:29 menno Exp $
 **/
+#include "../../audio_codecs.h"
+#if AUDIO_CODEC_AAC
+
 #include "Arduino.h"
 #include <stdlib.h>
 #include <stdint-gcc.h>
@@ -15901,3 +15904,4 @@ void sbr_qmf_analysis_32(sbr_info* sbr, qmfa_info* qmfa, const real_t* input, qm
 }
 #endif /*SBR_DEC*/
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
+#endif // AUDIO_CODEC_AAC
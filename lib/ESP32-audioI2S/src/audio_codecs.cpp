@@ -0,0 +1,56 @@
+/*
+ * audio_codecs.cpp
+ *
+ * The codec registry, one row per decoder. A decoder disabled in audio_codecs.h has no row and is not linked.
+ */
+#include "audio_codecs.h"
+#include "aac_decoder/aac_decoder.h"
+#include "flac_decoder/flac_decoder.h"
+#include "mp3_decoder/mp3_decoder.h"
+#include "opus_decoder/opus_decoder.h"
+#include "vorbis_decoder/vorbis_decoder.h"
+
+const AudioDecoder_t audioDecoders[] = {
+#if AUDIO_CODEC_MP3
+    {CODEC_MP3, "MP3", 1600, false, true, MP3Decoder_IsInit, MP3Decoder_AllocateBuffers, MP3Decoder_ClearBuffer, MP3Decoder_FreeBuffers,
+        MP3FindSyncWord,
+        [](uint8_t* in, int32_t* left, int16_t* out) -> int32_t { return MP3Decode(in, left, out, 0); },
+        []() -> int32_t { return MP3GetOutputSamps() / MP3GetChannels(); },
+        MP3GetChannels, MP3GetSampRate, MP3GetBitsPerSample, MP3GetBitrate},
+#endif
+#if AUDIO_CODEC_AAC
+    {CODEC_AAC, "AAC", 1600, false, false, AACDecoder_IsInit, AACDecoder_AllocateBuffers, NULL, AACDecoder_FreeBuffers,
+        [](uint8_t* buf, int32_t n) -> int32_t { return AACFindSyncWord(buf, n); },
+        [](uint8_t* in, int32_t* left, int16_t* out) -> int32_t { return AACDecode(in, left, out); },
+        []() -> int32_t { return AACGetOutputSamps() / AACGetChannels(); },
+        []() -> int32_t { return AACGetChannels(); }, []() -> int32_t { return AACGetSampRate(); },
+        []() -> int32_t { return AACGetBitsPerSample(); }, []() -> int32_t { return AACGetBitrate(); }},
+    {CODEC_M4A, "AAC", 1600, false, false, AACDecoder_IsInit, AACDecoder_AllocateBuffers, NULL, AACDecoder_FreeBuffers,
+        NULL, // raw blocks, no sync word
+        [](uint8_t* in, int32_t* left, int16_t* out) -> int32_t { return AACDecode(in, left, out); },
+        []() -> int32_t { return AACGetOutputSamps() / AACGetChannels(); },
+        []() -> int32_t { return AACGetChannels(); }, []() -> int32_t { return AACGetSampRate(); },
+        []() -> int32_t { return AACGetBitsPerSample(); }, []() -> int32_t { return AACGetBitrate(); }},
+#endif
+#if AUDIO_CODEC_FLAC
+    {CODEC_FLAC, "FLAC", 4096 * 4, true, false, NULL, FLACDecoder_AllocateBuffers, NULL, FLACDecoder_FreeBuffers,
+        FLACFindSyncWord,
+        [](uint8_t* in, int32_t* left, int16_t* out) -> int32_t { return FLACDecode(in, left, out); },
+        []() -> int32_t { return FLACGetOutputSamps() / FLACGetChannels(); },
+        []() -> int32_t { return FLACGetChannels(); }, []() -> int32_t { return FLACGetSampRate(); },
+        []() -> int32_t { return FLACGetBitsPerSample(); }, []() -> int32_t { return FLACGetBitRate(); }},
+#endif
+#if AUDIO_CODEC_OPUS
+    {CODEC_OPUS, "OPUS", 1024, false, false, NULL, OPUSDecoder_AllocateBuffers, NULL, OPUSDecoder_FreeBuffers,
+        OPUSFindSyncWord, OPUSDecode, []() -> int32_t { return OPUSGetOutputSamps(); },
+        []() -> int32_t { return OPUSGetChannels(); }, []() -> int32_t { return OPUSGetSampRate(); },
+        []() -> int32_t { return OPUSGetBitsPerSample(); }, []() -> int32_t { return OPUSGetBitRate(); }},
+#endif
+#if AUDIO_CODEC_VORBIS
+    {CODEC_VORBIS, "VORBIS", 4096 * 2, true, false, NULL, VORBISDecoder_AllocateBuffers, NULL, VORBISDecoder_FreeBuffers,
+        VORBISFindSyncWord, VORBISDecode, []() -> int32_t { return VORBISGetOutputSamps(); },
+        []() -> int32_t { return VORBISGetChannels(); }, []() -> int32_t { return VORBISGetSampRate(); },
+        []() -> int32_t { return VORBISGetBitsPerSample(); }, []() -> int32_t { return VORBISGetBitRate(); }},
+#endif
+    {CODEC_NONE, NULL, 0, false, false, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL} // end of list
+};
@@ -0,0 +1,60 @@
+/*
+ * audio_codecs.h
+ *
+ * Build-time codec selection, the decoder interface and the codec registry (audio_codecs.cpp).
+ *
+ * Every decoder is compiled in by default. A project that only ships some formats can drop the others
+ * from the image with build flags, e.g. in platformio.ini:
+ *
+ *     build_flags = -D AUDIO_CODEC_AAC=0 -D AUDIO_CODEC_FLAC=0 -D AUDIO_CODEC_OPUS=0 -D AUDIO_CODEC_VORBIS=0
+ *
+ * A disabled decoder's translation units compile to nothing and files of that format are rejected by
+ * Audio::initializeDecoder() as unsupported. WAV (PCM) needs no decoder and is always available.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef AUDIO_CODEC_MP3
+  #define AUDIO_CODEC_MP3    1
+#endif
+#ifndef AUDIO_CODEC_AAC
+  #define AUDIO_CODEC_AAC    1   // AAC and M4A, libfaad
+#endif
+#ifndef AUDIO_CODEC_FLAC
+  #define AUDIO_CODEC_FLAC   1
+#endif
+#ifndef AUDIO_CODEC_OPUS
+  #define AUDIO_CODEC_OPUS   1   // CELT and SILK
+#endif
+#ifndef AUDIO_CODEC_VORBIS
+  #define AUDIO_CODEC_VORBIS 1
+#endif
+
+// the formats of Audio, OGG is resolved to FLAC, OPUS or VORBIS from its first page
+enum : int { CODEC_NONE = 0, CODEC_WAV = 1, CODEC_MP3 = 2, CODEC_AAC = 3, CODEC_M4A = 4, CODEC_FLAC = 5,
+             CODEC_AACP = 6, CODEC_OPUS = 7, CODEC_OGG = 8, CODEC_VORBIS = 9};
+
+typedef struct AudioDecoder {
+    uint8_t     codec;                // CODEC_xxx served by this entry
+    const char* name;
+    size_t      maxFrameSize;         // InBuff block size while this decoder is active
+    bool        needsPSRAM;
+    bool        keepBuffers;          // buffers survive the end of a local file and are reused by the next one
+    bool      (*isInit)(void);        // NULL: allocateBuffers() is called for every file
+    bool      (*allocateBuffers)(void);
+    void      (*clearBuffers)(void);  // NULL: nothing to reset when the buffers are reused
+    void      (*freeBuffers)(void);
+    int32_t   (*findSyncWord)(uint8_t* buf, int32_t nBytes);
+    int32_t   (*decode)(uint8_t* inbuf, int32_t* bytesLeft, int16_t* outbuf);
+    int32_t   (*getOutputSamps)(void);  // samples per channel of the last decode()
+    int32_t   (*getChannels)(void);
+    int32_t   (*getSampRate)(void);
+    int32_t   (*getBitsPerSample)(void);
+    int32_t   (*getBitRate)(void);
+} AudioDecoder_t;
+
+// one entry per decoder enabled above, AAC has two (ADTS and M4A), the list ends with name == NULL
+extern const AudioDecoder_t audioDecoders[];
@@ -9,6 +9,9 @@
  * Author: Wolle
  *
  */
+#include "../audio_codecs.h"
+#if AUDIO_CODEC_FLAC
+
 #include "flac_decoder.h"
 #include "vector"
 using namespace std;
@@ -1106,3 +1109,4 @@ char* flac_x_ps_strndup(const char* str, uint16_t n) {
     return ps_str;
 }
 //----------------------------------------------------------------------------------------------------------------------
+#endif // AUDIO_CODEC_FLAC
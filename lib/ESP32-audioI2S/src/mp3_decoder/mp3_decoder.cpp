@@ -5,6 +5,9 @@
  *  Created on: 26.10.2018
  *  Updated on: 09.09.2024
  */
+#include "../audio_codecs.h"
+#if AUDIO_CODEC_MP3
+
 #include "mp3_decoder.h"
 /* clip to range [-2^n, 2^n - 1] */
 #if 0 //Fast on ARM:
@@ -1570,8 +1573,8 @@ void MP3Decoder_ClearBuffer(void) {
  * Return:      pointer to MP3DecInfo structure (initialized with pointers to all
  *                the internal buffers needed for decoding)
  *
- * Notes:       if one or more mallocs fail, function frees any buffers already
- *                allocated before returning
+ * Notes:       the state is held in a single arena that is allocated once and kept
+ *                until MP3Decoder_FreeBuffers(), later calls only clear it
  *
  **********************************************************************************************************************/
 
@@ -1585,23 +1588,39 @@ void MP3Decoder_ClearBuffer(void) {
         heap_caps_malloc_prefer(size, 2, MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL, MALLOC_CAP_DEFAULT|MALLOC_CAP_SPIRAM)
 #endif
 
+// All decoder state lives in one block. It is allocated on first use and kept across files, so consecutive
+// clips do not fragment the heap; MP3Decoder_ClearBuffer() resets it for every new file.
+typedef struct MP3DecoderArena {
+    MP3DecInfo_t    decInfo;
+    FrameHeader_t   frameHeader;
+    SideInfo_t      sideInfo;
+    ScaleFactorJS_t scaleFactorJS;
+    HuffmanInfo_t   huffmanInfo;
+    DequantInfo_t   dequantInfo;
+    IMDCTInfo_t     imdctInfo;
+    SubbandInfo_t   subbandInfo;
+    MP3FrameInfo_t  frameInfo;
+} MP3DecoderArena_t;
+
+static MP3DecoderArena_t *m_MP3DecoderArena = NULL;
+
 bool MP3Decoder_AllocateBuffers(void) {
-    if(!m_MP3DecInfo)       {m_MP3DecInfo    = (MP3DecInfo_t*)    __malloc_heap_psram(sizeof(MP3DecInfo_t)   );}
-    if(!m_FrameHeader)      {m_FrameHeader   = (FrameHeader_t*)   __malloc_heap_psram(sizeof(FrameHeader_t)  );}
-    if(!m_SideInfo)         {m_SideInfo      = (SideInfo_t*)      __malloc_heap_psram(sizeof(SideInfo_t)     );}
-    if(!m_ScaleFactorJS)    {m_ScaleFactorJS = (ScaleFactorJS_t*) __malloc_heap_psram(sizeof(ScaleFactorJS_t));}
-    if(!m_HuffmanInfo)      {m_HuffmanInfo   = (HuffmanInfo_t*)   __malloc_heap_psram(sizeof(HuffmanInfo_t)  );}
-    if(!m_DequantInfo)      {m_DequantInfo   = (DequantInfo_t*)   __malloc_heap_psram(sizeof(DequantInfo_t)  );}
-    if(!m_IMDCTInfo)        {m_IMDCTInfo     = (IMDCTInfo_t*)     __malloc_heap_psram(sizeof(IMDCTInfo_t)    );}
-    if(!m_SubbandInfo)      {m_SubbandInfo   = (SubbandInfo_t*)   __malloc_heap_psram(sizeof(SubbandInfo_t)  );}
-    if(!m_MP3FrameInfo)     {m_MP3FrameInfo  = (MP3FrameInfo_t*)  __malloc_heap_psram(sizeof(MP3FrameInfo_t) );}
-
-    if(!m_MP3DecInfo || !m_FrameHeader || !m_SideInfo || !m_ScaleFactorJS || !m_HuffmanInfo ||
-       !m_DequantInfo || !m_IMDCTInfo || !m_SubbandInfo || !m_MP3FrameInfo) {
-        MP3Decoder_FreeBuffers();
+    if(!m_MP3DecoderArena) {m_MP3DecoderArena = (MP3DecoderArena_t*) __malloc_heap_psram(sizeof(MP3DecoderArena_t));}
+
+    if(!m_MP3DecoderArena) {
         log_e("not enough memory to allocate mp3decoder buffers");
         return false;
     }
+    m_MP3DecInfo    = &m_MP3DecoderArena->decInfo;
+    m_FrameHeader   = &m_MP3DecoderArena->frameHeader;
+    m_SideInfo      = &m_MP3DecoderArena->sideInfo;
+    m_ScaleFactorJS = &m_MP3DecoderArena->scaleFactorJS;
+    m_HuffmanInfo   = &m_MP3DecoderArena->huffmanInfo;
+    m_DequantInfo   = &m_MP3DecoderArena->dequantInfo;
+    m_IMDCTInfo     = &m_MP3DecoderArena->imdctInfo;
+    m_SubbandInfo   = &m_MP3DecoderArena->subbandInfo;
+    m_MP3FrameInfo  = &m_MP3DecoderArena->frameInfo;
+
     MP3Decoder_ClearBuffer();
     return true;
 }
@@ -1618,11 +1637,7 @@ bool MP3Decoder_AllocateBuffers(void) {
 
  **********************************************************************************************************************/
 bool MP3Decoder_IsInit(void) {
-    if(!m_MP3DecInfo || !m_FrameHeader || !m_SideInfo || !m_ScaleFactorJS || !m_HuffmanInfo ||
-       !m_DequantInfo || !m_IMDCTInfo || !m_SubbandInfo || !m_MP3FrameInfo) {
-        return false;
-    }
-    return true;
+    return m_MP3DecoderArena != NULL;
 }
 /***********************************************************************************************************************
  * Function:    MP3Decoder_FreeBuffers
@@ -1641,15 +1656,17 @@ void MP3Decoder_FreeBuffers()
 {
 //    uint32_t i = ESP.getFreeHeap();
 
-    if(m_MP3DecInfo)        {free(m_MP3DecInfo);      m_MP3DecInfo=NULL;}
-    if(m_FrameHeader)       {free(m_FrameHeader);     m_FrameHeader=NULL;}
-    if(m_SideInfo)          {free(m_SideInfo);        m_SideInfo=NULL;}
-    if(m_ScaleFactorJS )    {free(m_ScaleFactorJS);   m_ScaleFactorJS=NULL;}
-    if(m_HuffmanInfo)       {free(m_HuffmanInfo);     m_HuffmanInfo=NULL;}
-    if(m_DequantInfo)       {free(m_DequantInfo);     m_DequantInfo=NULL;}
-    if(m_IMDCTInfo)         {free(m_IMDCTInfo);       m_IMDCTInfo=NULL;}
-    if(m_SubbandInfo)       {free(m_SubbandInfo);     m_SubbandInfo=NULL;}
-    if(m_MP3FrameInfo)      {free(m_MP3FrameInfo);    m_MP3FrameInfo=NULL;}
+    if(m_MP3DecoderArena)   {free(m_MP3DecoderArena); m_MP3DecoderArena=NULL;}
+
+    m_MP3DecInfo    = NULL;
+    m_FrameHeader   = NULL;
+    m_SideInfo      = NULL;
+    m_ScaleFactorJS = NULL;
+    m_HuffmanInfo   = NULL;
+    m_DequantInfo   = NULL;
+    m_IMDCTInfo     = NULL;
+    m_SubbandInfo   = NULL;
+    m_MP3FrameInfo  = NULL;
 
 //    log_i("MP3Decoder: %lu bytes memory was freed", ESP.getFreeHeap() - i);
 }
@@ -3866,3 +3883,4 @@ void PolyphaseStereo(int16_t *pcm, int32_t *vbuf, const uint32_t *coefBase){
         pcm += 2;
     }
 }
+#endif // AUDIO_CODEC_MP3
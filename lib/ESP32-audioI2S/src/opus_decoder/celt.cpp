@@ -31,6 +31,9 @@
    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ----------------------------------------------------------------------------------------------------------------------*/
 
+#include "../audio_codecs.h"
+#if AUDIO_CODEC_OPUS
+
 #include "celt.h"
 #include "opus_decoder.h"
 
@@ -3745,3 +3748,4 @@ void unquant_energy_finalise(int16_t *oldEBands, int32_t *fine_quant,
     }
 }
 //----------------------------------------------------------------------------------------------------------------------
+#endif // AUDIO_CODEC_OPUS
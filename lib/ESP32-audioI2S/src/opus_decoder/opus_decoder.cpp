@@ -8,6 +8,9 @@
 //----------------------------------------------------------------------------------------------------------------------
 //                                     O G G / O P U S     I M P L.
 //----------------------------------------------------------------------------------------------------------------------
+#include "../audio_codecs.h"
+#if AUDIO_CODEC_OPUS
+
 #include "opus_decoder.h"
 #include "celt.h"
 #include "silk.h"
@@ -1074,3 +1077,4 @@ int32_t OPUS_specialIndexOf(uint8_t* base, const char* str, int32_t baselen, boo
     }
     return result;
 }
+#endif // AUDIO_CODEC_OPUS
@@ -12,6 +12,9 @@ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DA
 LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ********************************************************************************************************************************************************************************************************/
 
+#include "../audio_codecs.h"
+#if AUDIO_CODEC_OPUS
+
 #include "silk.h"
 #include <stdint.h>
 
@@ -4238,3 +4241,4 @@ int32_t silk_VAD_Init(                           /* O    Return value, 0 if succ
 
     return (ret);
 }
+#endif // AUDIO_CODEC_OPUS
@@ -20,6 +20,9 @@
 //----------------------------------------------------------------------------------------------------------------------
 //                                     O G G    I M P L.
 //----------------------------------------------------------------------------------------------------------------------
+#include "../audio_codecs.h"
+#if AUDIO_CODEC_VORBIS
+
 #include "vorbis_decoder.h"
 #include "lookup.h"
 #include "alloca.h"
@@ -3291,3 +3294,4 @@ void mdct_unroll_lap(int32_t n0, int32_t n1, int32_t lW, int32_t W, int32_t *in,
     }
 }
 //---------------------------------------------------------------------------------------------------------------------
+#endif // AUDIO_CODEC_VORBIS
@@ -0,0 +1,119 @@
+// vi:ts=4
+// ----------------------------------------------------------------------------
+// LCDiSpeedBurst - LCD Interface Speed test of burst writes for hd44780_I2Cexp
+// ----------------------------------------------------------------------------
+// This sketch builds on the hd44780 library example LCDiSpeed.
+// It runs the same frame test (a full display of each digit 9 down to 0)
+// twice at each i2c clock rate:
+//
+// - per character: lcd.write(c) for every position, one i2c transfer per
+//   character, which is what the library did before burst writes.
+// - burst: lcd.write(buf, cols) for every row, the i/o class packs as many
+//   characters into one i2c transfer as the Wire buffer allows.
+//
+// Characters/second for each run are printed to the serial port and shown
+// on the lcd, so the speedup can be read on the device itself.
+//
+// Set LCD_INSEXECTIME to the execution time the display really needs;
+// burst writes idle the bus for it between characters, so a large value
+// cuts the gain.
+// ----------------------------------------------------------------------------
+
+#include <Wire.h>
+#include <hd44780.h>
+#include <hd44780ioClass/hd44780_I2Cexp.h> // include i/o class header
+
+#ifndef LCD_COLS
+#define LCD_COLS 20
+#endif
+#ifndef LCD_ROWS
+#define LCD_ROWS 4
+#endif
+
+//#define LCD_CHEXECTIME 2000
+//#define LCD_INSEXECTIME 38
+
+#define FPS_iter 1			// iterations of each digit frame
+#define DELAY_TIME 3500		// delay time to see information on lcd
+
+hd44780_I2Cexp lcd; // auto locate and autoconfig interface pins
+
+static const long clocks[] = {100000L, 400000L};
+
+unsigned long timeFrames(bool burst)
+{
+char c;
+char buf[LCD_COLS];
+unsigned long stime;
+
+	stime = micros();
+	for(c = '9'; c >= '0'; c--)
+	{
+		memset(buf, c, sizeof(buf));
+		for(uint8_t i = 0; i < FPS_iter; i++)
+		{
+			for(uint8_t row = 0; row < LCD_ROWS; row++)
+			{
+				lcd.setCursor(0, row);
+				if(burst)
+				{
+					lcd.write((const uint8_t *) buf, LCD_COLS);
+				}
+				else
+				{
+					for(uint8_t col = 0; col < LCD_COLS; col++)
+						lcd.write(c);
+				}
+			}
+		}
+	}
+	return(micros() - stime);
+}
+
+void showRate(long clock, bool burst, unsigned long etime)
+{
+	// setCursor() is counted as one character, it is one lcd transfer as well
+	unsigned long chars = 10UL * FPS_iter * LCD_ROWS * (LCD_COLS + 1);
+	unsigned long cps = (unsigned long)(chars * 1000000.0 / etime);
+
+	Serial.print(clock / 1000);
+	Serial.print(burst ? "kHz burst    " : "kHz per char ");
+	Serial.print(cps);
+	Serial.print(" chars/s, frame ");
+	Serial.print(etime / (10UL * FPS_iter));
+	Serial.println(" us");
+
+	lcd.clear();
+	lcd.print(clock / 1000);
+	lcd.print(burst ? "kHz burst" : "kHz per char");
+	lcd.setCursor(0, 1);
+	lcd.print(cps);
+	lcd.print(" chars/s");
+	delay(DELAY_TIME);
+}
+
+void setup(void)
+{
+	Serial.begin(115200);
+
+#if defined(LCD_CHEXECTIME) && defined(LCD_INSEXECTIME)
+	lcd.setExecTimes(LCD_CHEXECTIME, LCD_INSEXECTIME);
+#endif
+	if(lcd.begin(LCD_COLS, LCD_ROWS))
+	{
+		// begin() failed so blink the onboard LED if possible
+		hd44780::fatalError(1); // this never returns
+	}
+}
+
+void loop(void)
+{
+	for(uint8_t i = 0; i < sizeof(clocks) / sizeof(clocks[0]); i++)
+	{
+		Wire.setClock(clocks[i]);
+		delay(10); // ensure no previous commands still pending
+		showRate(clocks[i], false, timeFrames(false));
+		delay(10);
+		showRate(clocks[i], true, timeFrames(true));
+	}
+}
@@ -867,6 +867,139 @@ int rvalue = ioread(HD44780_IOdata);
 	return(rvalue);
 }
 
+// calibrateExecTimes() - measure the execution times of this module
+// Replaces the worst case clear/home and instruction/data times with what
+// the module actually needs, plus marginPct percent.
+//	- clear/home: the busy flag is polled after a clear
+//	- instruction/data: a pattern is written through write(buffer, size) at
+//	  decreasing execution times and read back, the shortest time that still
+//	  reads back correctly is kept. The search starts at
+//	  HD44780_CALIBRATE_INSFLOOR, the datasheet time, a faster pass depends
+//	  on the clock of the module on that day.
+// The margin is only added to a measured time, and no result is longer
+// than the time set by setExecTimes() before the call: a module that needs
+// all of it keeps it as it was.
+// The module clock drifts with temperature and supply voltage, the times
+// are measured once per call and the margin has to cover the drift after
+// it. Call it again to measure again.
+// Needs an i/o class that supports reads (r/w line wired), the display is
+// left cleared. The times are not changed on failure.
+// returns:
+// 	success: 0
+//	failure: negative value (error or read not supported by i/o subclass)
+int hd44780::calibrateExecTimes(uint8_t marginPct)
+{
+const uint32_t chExecTimeMax = _chExecTime;
+const uint32_t insExecTimeMax = _insExecTime;
+uint32_t chExecTime, insExecTime;
+uint32_t stime, lo, hi;
+uint8_t pattern[HD44780_CALIBRATE_CHARS];
+int rval;
+
+	waitReady();
+	if((rval = status()) < 0)
+		return(rval);
+
+	// clear: send it raw and poll BUSY, the poll itself is the resolution
+	if((rval = iowrite(HD44780_IOcmd, HD44780_CLEARDISPLAY)))
+		return(rval);
+	stime = (uint32_t) micros();
+	markStart(0); // status() must not wait out the worst case
+	do
+	{
+		if((rval = status()) < 0)
+			goto restore;
+		if(((uint32_t) micros()) - stime > 2 * chExecTimeMax)
+		{
+			rval = RV_EBUSY;
+			goto restore;
+		}
+	} while(rval & 0x80);
+	chExecTime = ((uint32_t) micros()) - stime;
+	chExecTime += (chExecTime * marginPct) / 100;
+	if(chExecTime > chExecTimeMax)
+		chExecTime = chExecTimeMax;
+	_curcol = 0;
+	_currow = 0;
+
+	// instruction/data: binary search for the shortest time that works
+	lo = HD44780_CALIBRATE_INSFLOOR;
+	hi = insExecTimeMax;
+	if(lo > hi)
+		lo = hi;
+	for(uint8_t i = 0; i < HD44780_CALIBRATE_CHARS; i++)
+		pattern[i] = 'A' + i;
+	while(lo < hi)
+	{
+	uint32_t mid = (lo + hi) / 2;
+	uint8_t ok = 1;
+
+		_insExecTime = mid;
+		for(uint8_t pass = 0; ok && pass < 2; pass++)
+		{
+			// second pass inverts the case so stale cells cannot match
+			for(uint8_t i = 0; i < HD44780_CALIBRATE_CHARS; i++)
+				pattern[i] ^= 0x20;
+			setCursor(0, 0);
+			if(write(pattern, HD44780_CALIBRATE_CHARS) != HD44780_CALIBRATE_CHARS)
+				ok = 0;
+			_insExecTime = insExecTimeMax; // read back at the safe time
+			setCursor(0, 0);
+			for(uint8_t i = 0; ok && i < HD44780_CALIBRATE_CHARS; i++)
+			{
+				if(read() != pattern[i])
+					ok = 0;
+			}
+			_insExecTime = mid;
+		}
+		if(ok)
+			hi = mid;
+		else
+		{
+			// an instruction the LCD missed may have split a byte, in
+			// 4 bit mode every nibble after it lands in the wrong half
+			_insExecTime = insExecTimeMax;
+			if((rval = resync()))
+				goto restore;
+			lo = mid + 1;
+		}
+	}
+	insExecTime = lo;
+	if(insExecTime < insExecTimeMax)
+	{
+		insExecTime += (insExecTime * marginPct) / 100;
+		if(insExecTime > insExecTimeMax)
+			insExecTime = insExecTimeMax;
+	}
+
+	_chExecTime = chExecTime;
+	_insExecTime = insExecTime;
+	return(clear());
+
+restore:
+	_chExecTime = chExecTimeMax;
+	_insExecTime = insExecTimeMax;
+	markStart(_chExecTime);
+	return(rval);
+}
+
+// resync() - the 8 bit/4 bit part of the begin() init sequence
+// Three 8 bit function sets put the LCD in 8 bit mode from any state,
+// including half way through a byte in 4 bit mode, then it goes back to
+// the mode begin() set. The display contents and modes are kept.
+int hd44780::resync()
+{
+	command4bit(HD44780_FUNCTIONSET|HD44780_8BITMODE);
+	delay(5); // as begin()
+	command4bit(HD44780_FUNCTIONSET|HD44780_8BITMODE);
+	delay(1);
+	command4bit(HD44780_FUNCTIONSET|HD44780_8BITMODE);
+	delay(1);
+	if(!(_displayfunction & HD44780_8BITMODE))
+		command4bit(HD44780_FUNCTIONSET|HD44780_4BITMODE);
+	return(command(HD44780_FUNCTIONSET | _displayfunction));
+}
+
 // write() - process data character byte to lcd
 // returns number of bytes successfully written to device
 // i.e. 1 if success or 0 if no character was processed (error)
@@ -904,6 +1037,28 @@ int status = 1; //assume success
 	return status;
 }
 
+// write() - send a run of characters to lcd
+// the i/o class may send several characters per transfer through iowriteBurst()
+// returns the number of characters sent
+size_t hd44780::write(const uint8_t *buffer, size_t size)
+{
+size_t sent = 0;
+
+	// line wrapping needs the per character cursor tracking of write(uint8_t)
+	if(_wraplines)
+		return(Print::write(buffer, size));
+
+	while(sent < size)
+	{
+		int n = iowriteBurst(HD44780_IOdata, buffer + sent, size - sent);
+		if(n <= 0)
+			break; // write was unsuccessful
+		markStart(_insExecTime);
+		sent += n;
+	}
+	return(sent);
+}
+
 //============================================================================
 // A couple of functions that really shouldn't be here.
 // blinkLED() and fatalError()
@@ -100,6 +100,8 @@ public:
 	// these can be overridden using setExecTimes(chUs, insUs)
 	static const int HD44780_CHEXECTIME = 2000; // time in us for clear&home
 	static const int HD44780_INSEXECTIME = 38;
+	static const int HD44780_CALIBRATE_CHARS = 16; // pattern length of calibrateExecTimes()
+	static const int HD44780_CALIBRATE_INSFLOOR = HD44780_INSEXECTIME; // calibrateExecTimes() never goes below
 
 	// API return values
 	// 0 means successful, less than zero means unsuccessful
@@ -193,6 +195,7 @@ public:
 	int setCursor(uint8_t col, uint8_t row); 
 	size_t write(uint8_t value);	// does char & line processing
 	size_t _write(uint8_t value);	// does not do char & line processing
+	size_t write(const uint8_t *buffer, size_t size); // uses burst writes when not wrapping lines
 // write() overloads for 0 or null which is an int
 // This is only because Print class doesn't do it.
 	inline size_t write(unsigned int value) { return(write((uint8_t)value)); }
@@ -351,6 +354,12 @@ public:
 	// set execution times for commmands to override defaults
 	inline void setExecTimes(uint32_t chExecTimeUs, uint32_t insExecTimeUs)
 		{ _chExecTime = chExecTimeUs; _insExecTime = insExecTimeUs;}
+	inline void getExecTimes(uint32_t &chExecTimeUs, uint32_t &insExecTimeUs)
+		{ chExecTimeUs = _chExecTime; insExecTimeUs = _insExecTime;}
+
+	// measure the execution times using reads, needs the r/w line
+	// measures once per call, the margin has to cover clock drift after it
+	int calibrateExecTimes(uint8_t marginPct = 25);
 
 	// A few undocumented helper functions for the included examples
 	static int blinkLED(int blinks);		// blink a built in LED if possible
@@ -378,6 +387,9 @@ protected:
 	inline void _waitReady(uint32_t _stime, uint32_t _etime)
 		{while(( ((uint32_t)micros()) - _stime) < _etime){}}
 
+	// execution time of instructions and data, for i/o classes that pace a burst themselves
+	inline uint32_t insExecTime() {return(_insExecTime);}
+
 private:
 
 	uint8_t _curcol;	// current LCD col if doing char & line processing
@@ -388,6 +400,10 @@ private:
 	virtual int ioinit() {return 0;}	// optional - successful if not implemented
 	virtual int ioread(hd44780::iotype type) {if(type) return(RV_ENOTSUP);else return(RV_ENOTSUP);}	// optional, return fail if not implemented
 	virtual int iowrite(hd44780::iotype type, uint8_t value)=0;// mandatory
+	// optional - send the first bytes of buf, returns the number of bytes sent or <= 0 on failure
+	// the default sends one byte, i/o classes that can pack several bytes into one transfer override it
+	virtual int iowriteBurst(hd44780::iotype type, const uint8_t *buf, size_t len)
+		{if(!len || iowrite(type, *buf)) return(RV_EIO); else return(1);}
 	virtual int iosetBacklight(uint8_t dimvalue){if(dimvalue) return(RV_ENOTSUP); else return(RV_ENOTSUP);}	// optional
 	virtual int iosetContrast(uint8_t contvalue){if(contvalue) return(RV_ENOTSUP); else return(RV_ENOTSUP);}// optional
 
@@ -408,6 +424,9 @@ private:
 		return(status);
 	}
 
+	// internal API function to get the LCD back in step after a lost nibble
+	int resync();
+
 };
 
 // LED_BUILTIN define fixups for Teensy, ChipKit, ESP8266, ESP32 cores
@@ -104,6 +104,15 @@
 #error hd44780_I2Cexp i/o class requires Arduino 1.0.1 or later
 #endif
 
+// size of the Wire transmit buffer, limits the bytes sent in one burst
+#if defined(I2C_BUFFER_LENGTH)
+#define I2CEXP_BUFFER_LENGTH I2C_BUFFER_LENGTH
+#elif defined(BUFFER_LENGTH)
+#define I2CEXP_BUFFER_LENGTH BUFFER_LENGTH
+#else
+#define I2CEXP_BUFFER_LENGTH 32
+#endif
+
 // canned i2c board/backpack parameters
 // allows using:
 // hd44780_I2Cexp lcd(I2Cexp_BOARD_XXX); // auto locate
@@ -640,6 +649,70 @@ int iowrite(hd44780::iotype type, uint8_t value)
 	return(hd44780::RV_ENOERR);
 }
 
+// iowriteBurst(type, buf, len) - send a run of bytes in a single i2c transfer
+// returns the number of bytes sent, or an error (<0)
+int iowriteBurst(hd44780::iotype type, const uint8_t *buf, size_t len)
+{
+	// If no address or expander type is unknown, then drop data
+	if(!_addr || _expType == I2Cexp_UNKNOWN)
+		return(hd44780::RV_ENXIO);
+	if(!len)
+		return(hd44780::RV_EINVAL);
+
+	/*
+	 * Every byte is 4 expander writes (2 nibbles, each with E high then low)
+	 * and the i2c bus time of those writes paces the LCD.
+	 * When the execution time is longer than the bus time of one
+	 * expander write, idle writes (E LOW, port unchanged) are added after
+	 * each byte so the next byte is not strobed in before the LCD is ready.
+	 * As many bytes as fit into the Wire buffer go into one transfer.
+	 */
+#if defined(ARDUINO_ARCH_ESP32)
+	uint32_t clock = Wire.getClock();
+#else
+	uint32_t clock = 400000; // unknown, assume the fastest to never send too fast
+#endif
+	if(!clock)
+		clock = 100000;
+	uint32_t byteUs = 9000000UL / clock; // 8 data bits + ack
+	if(!byteUs)
+		byteUs = 1;
+	uint32_t pad = (insExecTime() + byteUs - 1) / byteUs;
+	if(pad)
+		pad--; // the first expander write of the next byte also passes time
+	size_t room = I2CEXP_BUFFER_LENGTH - ((_expType == I2Cexp_MCP23008) ? 1 : 0);
+	size_t n = 1;
+	if(4 + pad <= room)
+		n = (room + pad) / (4 + pad); // no idle writes after the last byte
+	else
+		pad = 0; // too slow for a burst, one byte per transfer paced by waitReady()
+	if(n > len)
+		n = len;
+
+	waitReady(-45); // see iowrite()
+
+	Wire.beginTransmission(_addr);
+	if(_expType == I2Cexp_MCP23008)
+	{
+		Wire.write(9); // point to GPIO
+	}
+	for(size_t i = 0; i < n; i++)
+	{
+		uint8_t idle;
+		write4bits( (buf[i] >> 4), type );        // upper nibble
+		idle = write4bits( (buf[i] & 0x0F), type); // lower nibble
+		if(i + 1 < n)
+		{
+			for(uint32_t p = 0; p < pad; p++)
+				Wire.write(idle);
+		}
+	}
+	if(Wire.endTransmission()) // send buffered bytes to the expander
+		return(hd44780::RV_EIO);
+
+	return((int) n);
+}
+
 // iosetBacklight()  - set backlight brightness
 // Since dimming is not supported, any non zero value
 // will turn on the backlight.
@@ -1183,7 +1256,8 @@ uint8_t blLevel;
 
 
 // write4bits - send a nibble to the LCD through i/o expander port
-void write4bits(uint8_t value, hd44780::iotype type ) 
+// returns the port value left on the expander (E LOW)
+uint8_t write4bits(uint8_t value, hd44780::iotype type ) 
 {
 uint8_t gpioValue =  _blCurState;
    
@@ -1211,6 +1285,7 @@ uint8_t gpioValue =  _blCurState;
 	// This violates the spec but seems to work realiably.
 	Wire.write(gpioValue |_en);	// with E HIGH
 	Wire.write(gpioValue);		// with E LOW
+	return(gpioValue);
 }
 	
 }; // end of class definition
@@ -0,0 +1,92 @@
+/*
+ * Arduino.h
+ *
+ * The part of the Arduino ESP32 core the F3F sources use, on the host for
+ * env:native. Time comes from the virtual clock in sim.h.
+ */
+#ifndef ARDUINO_H_NATIVE
+#define ARDUINO_H_NATIVE
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "sim.h"
+#include "esp_heap_caps.h"
+
+#define PROGMEM
+#define IRAM_ATTR
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#ifndef __unused
+#define __unused __attribute__((unused))
+#endif
+
+typedef bool boolean;
+
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define HIGH 1
+#define LOW  0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+template<class T, class L> auto min(const T &a, const L &b) -> decltype(a < b ? a : b) { return (b < a) ? b : a; }
+template<class T, class L> auto max(const T &a, const L &b) -> decltype(a < b ? a : b) { return (a < b) ? b : a; }
+#define _min(a, b) ((a) < (b) ? (a) : (b))
+#define _max(a, b) ((a) > (b) ? (a) : (b))
+
+/* the core logs of the audio decoders, left out as in a release build */
+#define log_e(...) do {} while(0)
+#define log_w(...) do {} while(0)
+#define log_i(...) do {} while(0)
+#define log_d(...) do {} while(0)
+#define log_v(...) do {} while(0)
+
+/* the host heap stands in for PSRAM */
+static inline bool psramFound() { return true; }
+static inline void *ps_malloc(size_t size) { return heap_caps_malloc(size, MALLOC_CAP_SPIRAM); }
+static inline void *ps_calloc(size_t n, size_t size) { return heap_caps_calloc(n, size, MALLOC_CAP_SPIRAM); }
+
+static inline uint32_t millis() { return (uint32_t)(Sim_Micros() / 1000); }
+static inline uint32_t micros() { return (uint32_t)Sim_Micros(); }
+static inline void delay(uint32_t ms) { vTaskDelay(pdMS_TO_TICKS(ms)); }
+static inline void yield() {}
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+/* the wall clock is never set, as on a timer without network time */
+static inline time_t Sim_Time(time_t *t) { if(t) *t = 0; return 0; }
+#define time(t) Sim_Time(t)
+
+class HardwareSerial {
+public:
+	void begin(unsigned long baud) { (void)baud; }
+	size_t write(uint8_t c) { return fwrite(&c, 1, 1, stdout); }
+	size_t write(const uint8_t *p, size_t n) { return fwrite(p, 1, n, stdout); }
+	size_t write(const char *s) { return fputs(s, stdout) >= 0 ? strlen(s) : 0; }
+	size_t print(const char *s) { return write(s); }
+	size_t print(int v) { return printf("%d", v); }
+	size_t println(const char *s = "") { return printf("%s\n", s); }
+	size_t println(int v) { return printf("%d\n", v); }
+	size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)))
+	{
+		va_list ap;
+		va_start(ap, fmt);
+		int n = vprintf(fmt, ap);
+		va_end(ap);
+		return n < 0 ? 0 : n;
+	}
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * SD.h
+ *
+ * SD card of env:native, paths map to a host directory, NATIVE_SD_ROOT or
+ * $TMPDIR/f3f_sdcard by default.
+ */
+#ifndef SD_H_NATIVE
+#define SD_H_NATIVE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+class File {
+public:
+	File() : fp(NULL) {}
+	explicit File(FILE *f) : fp(f) {}
+
+	operator bool() const { return fp != NULL; }
+	size_t read(uint8_t *buf, size_t size) { return fp ? fread(buf, 1, size, fp) : 0; }
+	int read() { return fp ? fgetc(fp) : -1; }
+	size_t write(const uint8_t *buf, size_t size) { return fp ? fwrite(buf, 1, size, fp) : 0; }
+	bool seek(uint32_t pos) { return fp && fseek(fp, pos, SEEK_SET) == 0; }
+	size_t position() { return fp ? ftell(fp) : 0; }
+	size_t size();
+	int available();
+	size_t readBytesUntil(char terminator, char *buf, size_t length);
+	void flush() { if(fp) fflush(fp); }
+	void close() { if(fp) fclose(fp); fp = NULL; }
+
+private:
+	FILE *fp;
+};
+
+class SDFS {
+public:
+	File open(const char *path, const char *mode = FILE_READ);
+	bool exists(const char *path);
+	bool mkdir(const char *path);
+	bool remove(const char *path);
+	bool rename(const char *from, const char *to);
+};
+
+extern SDFS SD;
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ * WebServer.h
+ *
+ * The web server of env:native, a loopback without sockets. nativeRequest()
+ * queues a GET, handleClient() runs its handler and the response goes into a
+ * string as the core's WebServer writes it to the client, chunked framing
+ * included. A client can drop after a number of bytes, connected() is false
+ * from then on and the rest of the response is lost.
+ */
+#ifndef WEBSERVER_H_NATIVE
+#define WEBSERVER_H_NATIVE
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define HTTP_GET 1
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+
+class WebServer;
+
+class WebServerArg {
+public:
+	explicit WebServerArg(const std::string &s) : value(s) {}
+	long toInt() const;
+
+private:
+	std::string value;
+};
+
+class WiFiClient {
+public:
+	explicit WiFiClient(WebServer *s) : server(s) {}
+	bool connected();
+
+private:
+	WebServer *server;
+};
+
+class WebServer {
+public:
+	explicit WebServer(int port);
+	void on(const char *uri, int method, std::function<void()> handler);
+	void begin() {}
+	void handleClient();
+	bool hasArg(const char *name);
+	WebServerArg arg(const char *name);
+	void setContentLength(size_t len) { contentLength = len; }
+	void sendHeader(const char *name, const char *value, bool first = false);
+	void send(int code, const char *type, const char *content);
+	void sendContent(const char *content, size_t len);
+	void sendContent(const char *content);
+	WiFiClient client() { return WiFiClient(this); }
+
+	/* env:native */
+	static WebServer *nativeServer;     /* the last one constructed */
+	void nativeRequest(const char *uri, size_t dropAfter = (size_t)-1);
+	std::string nativeResponse();       /* what the client got, cleared */
+	size_t nativeOffered() { return offered; } /* bytes of the last response written, lost ones included */
+	bool nativeConnected() { return sent < dropAfter; }
+
+private:
+	struct Route {
+		std::string uri;
+		std::function<void()> handler;
+	};
+
+	void write(const char *p, size_t len);
+
+	std::vector<Route> routes;
+	std::string pendingUri;             /* empty, no request */
+	std::string query;
+	std::string headers;
+	std::string response;
+	size_t contentLength = CONTENT_LENGTH_NOT_SET;
+	size_t sent = 0;
+	size_t offered = 0;
+	size_t dropAfter = (size_t)-1;
+	bool chunked = false;
+};
+
+#endif
@@ -0,0 +1,245 @@
+#include <Arduino.h>
+#include <dirent.h>
+#include <malloc.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "audio_codecs.h"
+#include "native.h"
+
+/*
+* -b <dir> decodes every audio file of a host directory with the decoders of
+* ESP32-audioI2S, without output, and prints one JSON object per file. -b can
+* be given more than once.
+*
+* Every file is decoded twice. The cold run frees the decoder buffers first,
+* as after a decoder of another format played. The warm run follows and keeps
+* what the cold run left, as the player keeps the MP3 arena from one clip to
+* the next. The other decoders allocate on every file, their two runs differ
+* by the host cache only.
+*
+* Per run: the init time, the decode time and the time per second of audio
+* on the host CPU, and the peak of the host heap over the baseline before
+* init, sampled after the init and after every decode call. caps_allocs
+* counts the blocks the decoders took from the heap_caps allocators,
+* ps_malloc included. A plain malloc() or new is not in it, the heap peak
+* covers those. The files are read whole before the clock starts, SD speed
+* is not part of it.
+*
+* WAV has no decoder, AAC is left out, libfaad carries Xtensa assembly.
+*/
+#define BENCH_OUT_SAMPLES (4096 * 2)  /* Audio::m_outbuffSize */
+
+typedef struct {
+	const char *ext;
+	const char *oggTag;         /* in the first Ogg page, NULL no Ogg stream */
+	uint8_t codec;
+} BenchCodec;
+
+typedef struct {
+	uint32_t initUs;
+	uint32_t decodeUs;
+	uint32_t heapPeak;
+	uint32_t capsAllocs;
+	uint32_t frames;
+	uint32_t errors;
+	uint64_t samples;
+	uint32_t sampleRate;
+} BenchRun;
+
+/* the file types of Audio, the decoders come from audioDecoders[] */
+static const BenchCodec benchCodecs[] = {
+	{ ".mp3", NULL, CODEC_MP3 },
+	{ ".flac", NULL, CODEC_FLAC },
+	{ ".opus", "OpusHead", CODEC_OPUS },
+	{ ".ogg", "vorbis", CODEC_VORBIS },
+	{ ".ogg", "OpusHead", CODEC_OPUS },
+};
+
+static bool Bench_EndsWith(const std::string &s, const char *ext)
+{
+	size_t n = strlen(ext);
+	return s.size() >= n && strcasecmp(s.c_str() + s.size() - n, ext) == 0;
+}
+
+static const AudioDecoder_t *Bench_Decoder(uint8_t codec)
+{
+	for(const AudioDecoder_t *d = audioDecoders; d->name; d++) {
+		if(d->codec == codec)
+			return d;
+	}
+	return NULL;
+}
+
+/* as Audio::determineOggCodec(), the tag sits in the first page */
+static const AudioDecoder_t *Bench_Find(const std::string &path, const std::vector<uint8_t> &data)
+{
+	for(const BenchCodec &c : benchCodecs) {
+		if(!Bench_EndsWith(path, c.ext))
+			continue;
+		if(!c.oggTag)
+			return Bench_Decoder(c.codec);
+		size_t n = std::min(data.size(), (size_t)128);
+		if(std::search(data.begin(), data.begin() + n, c.oggTag, c.oggTag + strlen(c.oggTag)) != data.begin() + n)
+			return Bench_Decoder(c.codec);
+	}
+	return NULL;
+}
+
+/* an ID3v2 tag may hold false MP3 sync words, Audio::indexMP3Header() skips it too */
+static size_t Bench_Id3Size(const std::vector<uint8_t> &d)
+{
+	if(d.size() < 10 || memcmp(d.data(), "ID3", 3) != 0)
+		return 0;
+	size_t size = 10 + ((d[6] & 0x7f) << 21 | (d[7] & 0x7f) << 14 | (d[8] & 0x7f) << 7 | (d[9] & 0x7f));
+	if(d[5] & 0x10)
+		size += 10; /* footer */
+	return std::min(size, d.size());
+}
+
+static size_t Bench_HeapUsed()
+{
+	return mallinfo2().uordblks;
+}
+
+static uint32_t Bench_Us(std::chrono::steady_clock::time_point t0)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+}
+
+/*
+* The loop of Audio::sendBytes() over a file held in memory: a sync word is
+* searched only after an error, a block is handed over once maxFrameSize bytes
+* are there or the file ended, a failed decode skips one byte. A header page
+* (xxx_PARSE_OGG_DONE) may take no bytes, the decoder moved on by one state.
+*/
+static bool Bench_Decode(const AudioDecoder_t *dec, const std::vector<uint8_t> &data, size_t start, BenchRun *r)
+{
+	static int16_t out[BENCH_OUT_SAMPLES];
+	size_t base = Bench_HeapUsed();
+	size_t peak = base;
+	uint32_t allocs = Native_CapsAllocs();
+
+	memset(r, 0, sizeof(*r));
+	auto t0 = std::chrono::steady_clock::now();
+	bool res = (dec->isInit && dec->isInit()) ? true : dec->allocateBuffers();
+	if(res && dec->clearBuffers)
+		dec->clearBuffers();
+	r->initUs = Bench_Us(t0);
+	peak = std::max(peak, Bench_HeapUsed());
+
+	size_t pos = start;
+	bool playing = false;
+	while(res && pos < data.size()) {
+		uint8_t *p = (uint8_t *)data.data() + pos;
+		int32_t avail = std::min(data.size() - pos, dec->maxFrameSize);
+
+		if(!playing) {
+			int32_t sync = dec->findSyncWord ? dec->findSyncWord(p, avail) : 0;
+			if(sync < 0) {
+				pos += avail > 3 ? avail - 3 : avail; /* a sync word may span the block boundary */
+				continue;
+			}
+			pos += sync;
+			playing = sync == 0;
+			continue;
+		}
+
+		int32_t bytesLeft = avail;
+		t0 = std::chrono::steady_clock::now();
+		int32_t err = dec->decode(p, &bytesLeft, out);
+		r->decodeUs += Bench_Us(t0);
+		peak = std::max(peak, Bench_HeapUsed());
+
+		int32_t used = avail - bytesLeft;
+		if(err < 0 || (err == 0 && used == 0)) {
+			r->errors++;
+			playing = false;
+			used = 1;
+		}
+		else if(err != 100) { /* xxx_PARSE_OGG_DONE */
+			int32_t n = dec->getOutputSamps();
+			if(n > 0) {
+				r->frames++;
+				r->samples += n;
+				r->sampleRate = dec->getSampRate();
+			}
+		}
+		pos += used;
+	}
+	if(!dec->keepBuffers)
+		dec->freeBuffers();
+
+	r->heapPeak = peak - base;
+	r->capsAllocs = Native_CapsAllocs() - allocs;
+	return res;
+}
+
+static void Bench_PrintRun(const char *name, const BenchRun *r)
+{
+	double audioSec = r->sampleRate ? (double)r->samples / r->sampleRate : 0;
+
+	printf("\"%s\":{\"init_us\":%u,\"decode_us\":%u,\"us_per_audio_s\":%u,\"heap_peak\":%u,\"caps_allocs\":%u}", name,
+		(unsigned)r->initUs, (unsigned)r->decodeUs, (unsigned)(audioSec > 0 ? r->decodeUs / audioSec : 0),
+		(unsigned)r->heapPeak, (unsigned)r->capsAllocs);
+}
+
+static bool Bench_File(const std::string &path, bool first)
+{
+	std::vector<uint8_t> data;
+	FILE *f = fopen(path.c_str(), "rb");
+	if(!f)
+		return false;
+	uint8_t buf[4096];
+	size_t n;
+	while((n = fread(buf, 1, sizeof(buf), f)) > 0)
+		data.insert(data.end(), buf, buf + n);
+	fclose(f);
+
+	const AudioDecoder_t *dec = Bench_Find(path, data);
+	if(!dec)
+		return false;
+	size_t start = dec->keepBuffers ? Bench_Id3Size(data) : 0;
+
+	BenchRun cold, warm;
+	dec->freeBuffers();
+	bool res = Bench_Decode(dec, data, start, &cold);
+	res = Bench_Decode(dec, data, start, &warm) && res;
+
+	printf("%s\n {\"file\":\"%s\",\"codec\":\"%s\",\"ok\":%s,\"frames\":%u,\"errors\":%u,\"audio_s\":%.3f,", first ? "" : ",",
+		path.c_str(), dec->name, res ? "true" : "false", (unsigned)cold.frames, (unsigned)cold.errors,
+		cold.sampleRate ? (double)cold.samples / cold.sampleRate : 0.0);
+	Bench_PrintRun("cold", &cold);
+	printf(",");
+	Bench_PrintRun("warm", &warm);
+	printf("}");
+	return true;
+}
+
+int Native_Bench(const std::vector<const char *> &dirs)
+{
+	uint32_t files = 0;
+
+	printf("[");
+	for(const char *dir : dirs) {
+		std::vector<std::string> names;
+		DIR *d = opendir(dir);
+		if(!d) {
+			fprintf(stderr, "can not open %s\n", dir);
+			return 1;
+		}
+		while(struct dirent *e = readdir(d))
+			names.push_back(e->d_name);
+		closedir(d);
+		std::sort(names.begin(), names.end());
+
+		for(const std::string &name : names) {
+			if(Bench_File(std::string(dir) + "/" + name, files == 0))
+				files++;
+		}
+	}
+	printf("\n]\n");
+	fprintf(stderr, "%u files decoded\n", (unsigned)files);
+	return 0;
+}
@@ -0,0 +1,33 @@
+/*
+ * esp_heap_caps.h
+ *
+ * The heaps of env:native. There are none to watch, the getters return 0.
+ * The allocators take every cap from the host heap and count the blocks they
+ * handed out, for the decoder benchmark (bench_native.cpp). A plain malloc()
+ * or new is not counted.
+ */
+#ifndef ESP_HEAP_CAPS_H_NATIVE
+#define ESP_HEAP_CAPS_H_NATIVE
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT  (1 << 12)
+
+static inline size_t heap_caps_get_total_size(uint32_t caps) { (void)caps; return 0; }
+static inline size_t heap_caps_get_free_size(uint32_t caps) { (void)caps; return 0; }
+static inline size_t heap_caps_get_minimum_free_size(uint32_t caps) { (void)caps; return 0; }
+static inline size_t heap_caps_get_largest_free_block(uint32_t caps) { (void)caps; return 0; }
+
+void *heap_caps_malloc(size_t size, uint32_t caps);
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps);
+void *heap_caps_malloc_prefer(size_t size, size_t num, ...);
+void *heap_caps_calloc_prefer(size_t n, size_t size, size_t num, ...);
+void heap_caps_free(void *p);
+
+uint32_t Native_CapsAllocs(); /* blocks the allocators above handed out, ps_malloc() included */
+
+#endif
@@ -0,0 +1,14 @@
+/*
+ * esp_timer.h
+ *
+ * The microsecond timer of env:native, from the virtual clock.
+ */
+#ifndef ESP_TIMER_H_NATIVE
+#define ESP_TIMER_H_NATIVE
+
+#include <stdint.h>
+#include "sim.h"
+
+static inline int64_t esp_timer_get_time() { return (int64_t)Sim_Micros(); }
+
+#endif
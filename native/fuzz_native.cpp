@@ -0,0 +1,230 @@
+#include <Arduino.h>
+#include <vector>
+#include "modbus.h"
+#include "anemometer.h"
+#include "remote.h"
+#include "SerialReceiver/CRSF/CRSF.hpp"
+
+using namespace crsfProtocol;
+
+/*
+* -z <n> puts n damaged messages through every parser that takes bytes off the
+* air or the network. A message is a good one with up to 8 mutations: bit flips,
+* replaced, inserted and deleted bytes, a cut, random bytes at the end. Replaced
+* and inserted bytes come from the dictionary of the target half the time, the
+* characters a parser tells apart.
+*
+* Every message sits in a heap block of its own size, built with
+* -fsanitize=address the run stops at the first byte read past it. After every
+* message one of the next two good ones has to come through, a parser that
+* stalls on damage fails the run. The first one is lost only when the damage
+* ends in ":OOR", which takes the ':' of the next MODBUS frame as text. The
+* seed is fixed, the same n finds the same inputs.
+*/
+typedef struct {
+	const char *name;
+	const char *dict;
+	void (*good)(std::vector<uint8_t> &v);
+	void (*feed)(const uint8_t *p, size_t len);
+	bool (*resync)();           /* true if a good message comes through */
+} FuzzTarget;
+
+static uint32_t fuzzSeed = 0x9e3779b9;
+
+static uint32_t Fuzz_Random()
+{
+	fuzzSeed ^= fuzzSeed << 13;
+	fuzzSeed ^= fuzzSeed >> 17;
+	fuzzSeed ^= fuzzSeed << 5;
+	return fuzzSeed;
+}
+
+static uint8_t Fuzz_Byte(const char *dict)
+{
+	if(Fuzz_Random() & 1)
+		return Fuzz_Random();
+	return dict[Fuzz_Random() % strlen(dict)];
+}
+
+static void Fuzz_Mutate(std::vector<uint8_t> &v, const char *dict)
+{
+	for(uint32_t n = 1 + Fuzz_Random() % 8; n > 0; n--) {
+		size_t pos = v.empty() ? 0 : Fuzz_Random() % v.size();
+		switch(Fuzz_Random() % 6) {
+		case 0: if(!v.empty()) v[pos] ^= 1 << (Fuzz_Random() % 8); break;
+		case 1: if(!v.empty()) v[pos] = Fuzz_Byte(dict); break;
+		case 2: v.insert(v.begin() + pos, Fuzz_Byte(dict)); break;
+		case 3: if(!v.empty()) v.erase(v.begin() + pos); break;
+		case 4: v.resize(pos); break;
+		case 5:
+			for(uint32_t k = Fuzz_Random() % 64; k > 0; k--)
+				v.push_back(Fuzz_Random());
+			break;
+		}
+	}
+}
+
+/* anemometer, MODBUS-ASCII, the answer to a register read (anemometer.cpp) */
+static const uint8_t modbusGood[9] = { 0x01, 0x03, 0x06, 0x01, 0x0e, 0x00, 0x00, 0x40, 0xa8 };
+static ModbusAscii fuzzModbus;
+
+static void Fuzz_ModbusGood(std::vector<uint8_t> &v)
+{
+	char s[8];
+	uint8_t lrc = 0;
+
+	v.push_back(':');
+	for(size_t i = 0; i <= sizeof(modbusGood); i++) {
+		uint8_t b = (i < sizeof(modbusGood)) ? modbusGood[i] : -lrc;
+		snprintf(s, sizeof(s), "%02X", b);
+		v.insert(v.end(), s, s + 2);
+		if(i < sizeof(modbusGood))
+			lrc += b;
+	}
+	v.push_back('\r');
+	v.push_back('\n');
+}
+
+static void Fuzz_ModbusFeed(const uint8_t *p, size_t len)
+{
+	for(size_t i = 0; i < len; i++)
+		ModbusAscii_Feed(&fuzzModbus, p[i]);
+	Anemometer_Feed(p, len); /* and through the decoder, the samples go nowhere */
+}
+
+static bool Fuzz_ModbusResync()
+{
+	std::vector<uint8_t> v;
+	bool ok = false;
+
+	Fuzz_ModbusGood(v);
+	for(size_t i = 0; i < v.size(); i++) {
+		if(ModbusAscii_Feed(&fuzzModbus, v[i]) == modbusFrame)
+			ok = fuzzModbus.len == sizeof(modbusGood) && memcmp(fuzzModbus.data, modbusGood, sizeof(modbusGood)) == 0;
+	}
+	return ok;
+}
+
+/* remote base, "<A1234>" over UDP */
+static void Fuzz_RemoteGood(std::vector<uint8_t> &v)
+{
+	const char *s = "<A0815>";
+	v.insert(v.end(), s, s + strlen(s));
+}
+
+static void Fuzz_RemoteFeed(const uint8_t *p, size_t len)
+{
+	uint8_t base;
+	uint32_t serNo;
+	Remote_ParseBase(p, len, &base, &serNo);
+}
+
+static bool Fuzz_RemoteResync()
+{
+	uint8_t base;
+	uint32_t serNo;
+	return Remote_ParseBase((const uint8_t *)"<B0042>", REMOTE_BASE_SIZE, &base, &serNo) && base == 'B' && serNo == 42;
+}
+
+/* CRSF, RC channels from the receivers of the base judges */
+static serialReceiverLayer::CRSF *fuzzCrsf = NULL;
+static genericCrc::GenericCRC fuzzCrc;
+
+static uint16_t Fuzz_CrsfChannel(int i)
+{
+	return 172 + 100 * i;
+}
+
+static void Fuzz_CrsfGood(std::vector<uint8_t> &v)
+{
+	rcChannelsPacked_t rc;
+	uint16_t ch[RC_CHANNEL_COUNT];
+
+	for(int i = 0; i < RC_CHANNEL_COUNT; i++)
+		ch[i] = Fuzz_CrsfChannel(i);
+	rc.channel0 = ch[0]; rc.channel1 = ch[1]; rc.channel2 = ch[2]; rc.channel3 = ch[3];
+	rc.channel4 = ch[4]; rc.channel5 = ch[5]; rc.channel6 = ch[6]; rc.channel7 = ch[7];
+	rc.channel8 = ch[8]; rc.channel9 = ch[9]; rc.channel10 = ch[10]; rc.channel11 = ch[11];
+	rc.channel12 = ch[12]; rc.channel13 = ch[13]; rc.channel14 = ch[14]; rc.channel15 = ch[15];
+
+	const uint8_t *payload = (const uint8_t *)&rc;
+	v.push_back(CRSF_ADDRESS_FLIGHT_CONTROLLER);
+	v.push_back(CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE_CRC);
+	v.push_back(CRSF_FRAMETYPE_RC_CHANNELS_PACKED);
+	v.insert(v.end(), payload, payload + CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE);
+	v.push_back(fuzzCrc.calculate(CRSF_FRAMETYPE_RC_CHANNELS_PACKED, payload, CRSF_FRAME_RC_CHANNELS_PAYLOAD_SIZE));
+}
+
+static void Fuzz_CrsfFeed(const uint8_t *p, size_t len)
+{
+	for(size_t i = 0; i < len; i++)
+		fuzzCrsf->receiveFrames(p[i]);
+}
+
+/* after the gap between two frames, as on the UART */
+static bool Fuzz_CrsfResync()
+{
+	std::vector<uint8_t> v;
+	uint16_t ch[RC_CHANNEL_COUNT] = { 0 };
+
+	Sim_Run(2);
+	fuzzCrsf->getRcChannels(ch); /* drop whatever the damaged message left */
+	memset(ch, 0, sizeof(ch));
+	Fuzz_CrsfGood(v);
+	Fuzz_CrsfFeed(v.data(), v.size());
+	fuzzCrsf->getRcChannels(ch);
+	for(int i = 0; i < RC_CHANNEL_COUNT; i++) {
+		if(ch[i] != Fuzz_CrsfChannel(i))
+			return false;
+	}
+	return true;
+}
+
+static const FuzzTarget fuzzTargets[] = {
+	{ "modbus", ":0123456789ABCDEFabcdef\r\nOR", Fuzz_ModbusGood, Fuzz_ModbusFeed, Fuzz_ModbusResync },
+	{ "remote", "<>AB0123456789", Fuzz_RemoteGood, Fuzz_RemoteFeed, Fuzz_RemoteResync },
+	{ "crsf", "\x01\x02\x03\x16\x18\x3e\x3f\x40\xc8\xff", Fuzz_CrsfGood, Fuzz_CrsfFeed, Fuzz_CrsfResync },
+};
+
+int Native_Fuzz(uint32_t iterations)
+{
+	int failed = 0;
+
+	ModbusAscii_Reset(&fuzzModbus);
+	fuzzCrsf = new serialReceiverLayer::CRSF();
+	fuzzCrsf->begin();
+	fuzzCrsf->setFrameTime(BAUD_RATE, 10);
+
+	for(const FuzzTarget &t : fuzzTargets) {
+		uint32_t lost = 0, stalls = 0;
+
+		for(uint32_t i = 0; i < iterations; i++) {
+			std::vector<uint8_t> v;
+			t.good(v);
+			Fuzz_Mutate(v, t.dict);
+
+			uint8_t *p = (uint8_t *)malloc(v.size() ? v.size() : 1);
+			memcpy(p, v.data(), v.size());
+			t.feed(p, v.size());
+			free(p);
+
+			if(t.resync())
+				continue;
+			lost++;
+			if(!t.resync()) {
+				if(stalls++ == 0) {
+					fprintf(stderr, "%s: no good message after input %u:", t.name, (unsigned)i);
+					for(uint8_t b : v)
+						fprintf(stderr, " %02x", b);
+					fprintf(stderr, "\n");
+				}
+			}
+		}
+		fprintf(stderr, "%-8s %u inputs, %u next messages lost, %u stalls\n", t.name, (unsigned)iterations, (unsigned)lost, (unsigned)stalls);
+		if(stalls)
+			failed = 1;
+	}
+
+	delete fuzzCrsf;
+	return failed;
+}
@@ -0,0 +1,28 @@
+#include <stdlib.h>
+#include <atomic>
+#include "esp_heap_caps.h"
+
+/*
+* Every cap is the host heap. The blocks are plain malloc() blocks, the
+* decoders free them with free() as on the device. Only the blocks of these
+* allocators are counted, malloc() and new of the host are not.
+*/
+static std::atomic<uint32_t> capsAllocs(0);
+
+static void *Heap_Count(void *p)
+{
+	if(p)
+		capsAllocs++;
+	return p;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps) { (void)caps; return Heap_Count(malloc(size)); }
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps) { (void)caps; return Heap_Count(calloc(n, size)); }
+void *heap_caps_malloc_prefer(size_t size, size_t num, ...) { (void)num; return Heap_Count(malloc(size)); }
+void *heap_caps_calloc_prefer(size_t n, size_t size, size_t num, ...) { (void)num; return Heap_Count(calloc(n, size)); }
+void heap_caps_free(void *p) { free(p); }
+
+uint32_t Native_CapsAllocs()
+{
+	return capsAllocs;
+}
@@ -0,0 +1,88 @@
+#include <Arduino.h>
+#include "lcd204.h"
+#include "native.h"
+#include "latency.h"
+
+/*
+* The 20 x 4 display as text. A row is traced when it changes, the big clock
+* once a second and whenever its label changes, the driver can dump all of it.
+*/
+static char lcdRows[4][LINE_SIZE + 1];
+static char bigLabel[2][5];
+static uint32_t bigTime = 0;
+
+static void lcdTraceRow(uint8_t row)
+{
+	Native_Trace("LCD%u |%s|", row, lcdRows[row]);
+}
+
+void lcd2004Setup()
+{
+	lcdClear();
+}
+
+void lcd2004Loop()
+{
+}
+
+void lcdPrintRow(uint8_t row, const char *fmt, ...)
+{
+	char str[LINE_SIZE + 1];
+	va_list args;
+
+	va_start(args, fmt);
+	int r = vsnprintf(str, LINE_SIZE + 1, fmt, args);
+	va_end(args);
+
+	if(r >= 0) {
+		if(r < LINE_SIZE)
+			memset(str + r, 0x20, LINE_SIZE - r);
+		lcdSetCells(row, 0, str, LINE_SIZE);
+	}
+}
+
+void lcdSetCells(uint8_t row, uint8_t col, const char *text, uint8_t len)
+{
+	if(row >= 4 || col >= LINE_SIZE)
+		return;
+	len = min((int)len, LINE_SIZE - col);
+	if(memcmp(&lcdRows[row][col], text, len) == 0)
+		return;
+	memcpy(&lcdRows[row][col], text, len);
+	lcdTraceRow(row);
+}
+
+void lcdBigTime(uint32_t time_ms)
+{
+	if(time_ms / 1000 != bigTime / 1000)
+		Native_Trace("BIG %-4s %3u.%02u", bigLabel[0], (unsigned)(time_ms / 1000), (unsigned)(time_ms % 1000) / 10);
+	bigTime = time_ms;
+}
+
+void lcdBigLabel(const char *top, const char *bottom)
+{
+	snprintf(bigLabel[0], sizeof(bigLabel[0]), "%s", top);
+	snprintf(bigLabel[1], sizeof(bigLabel[1]), "%s", bottom);
+	Native_Trace("BIG %-4s %-4s", bigLabel[0], bigLabel[1]);
+	LATENCY_MARK(LATENCY_LCD);
+	bigTime = 0xffffffff; /* the next time is traced whatever it is */
+}
+
+void lcdNoCursor()
+{
+}
+
+void lcdClear()
+{
+	for(int r = 0; r < 4; r++) {
+		memset(lcdRows[r], ' ', LINE_SIZE);
+		lcdRows[r][LINE_SIZE] = 0;
+	}
+}
+
+void Native_LcdDump()
+{
+	for(int r = 0; r < 4; r++)
+		Native_Trace("LCD%u |%s|", r, lcdRows[r]);
+	Native_Trace("BIG %-4s %-4s %3u.%02u", bigLabel[0], bigLabel[1], (unsigned)(bigTime / 1000), (unsigned)(bigTime % 1000) / 10);
+}
@@ -0,0 +1,276 @@
+#include <Arduino.h>
+#include <SD.h>
+#include "f3f.h"
+#include "log.h"
+#include "lcd204.h"
+#include "flightlog.h"
+#include "competition.h"
+#include "anemometer.h"
+#include "trace.h"
+#include "latency.h"
+#include "native.h"
+#include <chrono>
+#include <vector>
+
+/*
+* Runs the real F3F state machine on the host. A script of timed events drives
+* it, one per line, from a file or stdin:
+*
+*   <ms> start | stop | a | b        buttons
+*   <ms> baseA | baseB               wired base inputs
+*   <ms> remoteA | remoteB           bases from the radio or the network
+*   <ms> wind <m/s> <degrees>        an anemometer frame
+*   <ms> show                        dump the display
+*   <ms> end                         dump the display and stop
+*
+* The clock runs to <ms> before the event, so the trace is the same on every run.
+*
+* -r <file> replays a trigger trace recorded by the timer (trace.h) instead, at
+* the millisecond of every event. -g <ms> cuts idle gaps longer than that down to
+* it, -q leaves out the trace lines.
+*
+* -l runs the latency benchmark of a LATENCY_BENCHMARK build (latency.h) instead,
+* the stages stamp under the virtual clock, what is left is the task layout.
+*
+* -z <n> runs n damaged messages through each parser of untrusted input instead,
+* see fuzz_native.cpp.
+*
+* -b <dir> decodes the audio files of a host directory instead and prints the
+* decoder timing and heap use as JSON, see bench_native.cpp.
+*/
+HardwareSerial Serial;
+
+static bool nativeQuiet = false;
+
+void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+void digitalWrite(uint8_t pin, uint8_t val) { (void)pin; (void)val; }
+int digitalRead(uint8_t pin) { (void)pin; return HIGH; }
+
+void Native_Trace(const char *fmt, ...)
+{
+	va_list ap;
+
+	if(nativeQuiet)
+		return;
+	printf("%7u ", (unsigned)millis());
+	va_start(ap, fmt);
+	vprintf(fmt, ap);
+	va_end(ap);
+	printf("\n");
+}
+
+#ifndef PIO_UNIT_TESTING /* the tests in test/ bring their own main() */
+
+/* the answer of the anemometer to a register read, see anemometer.cpp */
+static void Native_Wind(float speed, uint16_t dir)
+{
+	uint8_t d[10], lrc = 0;
+	uint32_t bits;
+	char frame[32];
+	size_t n = 0;
+
+	memcpy(&bits, &speed, sizeof(bits));
+	d[0] = 1;
+	d[1] = 3;
+	d[2] = 6;
+	d[3] = dir >> 8;
+	d[4] = dir;
+	d[5] = bits >> 8;
+	d[6] = bits;
+	d[7] = bits >> 24;
+	d[8] = bits >> 16;
+	for(int i = 0; i < 9; i++)
+		lrc += d[i];
+	d[9] = -lrc;
+
+	frame[n++] = ':';
+	for(int i = 0; i < 10; i++)
+		n += sprintf(&frame[n], "%02X", d[i]);
+	frame[n++] = '\r';
+	frame[n++] = '\n';
+	Anemometer_Feed((const uint8_t *)frame, n);
+}
+
+static void Native_Event(uint8_t event, uint16_t serNo)
+{
+	switch(event) {
+	case TRACE_START: F3F_KeyStart(); break;
+	case TRACE_STOP: F3F_KeyStop(); break;
+	case TRACE_A: F3F_KeyA(); break;
+	case TRACE_B: F3F_KeyB(); break;
+	case TRACE_BASE_A: F3F_KeyBaseA(); break;
+	case TRACE_BASE_B: F3F_KeyBaseB(); break;
+	case TRACE_BASE_A | TRACE_REMOTE: F3F_TiggleBaseA(serNo); break;
+	case TRACE_BASE_B | TRACE_REMOTE: F3F_TiggleBaseB(serNo); break;
+	default:
+		fprintf(stderr, "unknown trace event %02x\n", event);
+		break;
+	}
+}
+
+/* Every boot in the trace starts a second after the previous one ended */
+static int Native_Replay(const char *path, uint32_t maxGap)
+{
+	FILE *f = fopen(path, "rb");
+	if(!f) {
+		fprintf(stderr, "can not open %s\n", path);
+		return 1;
+	}
+	std::vector<uint8_t> data;
+	uint8_t buf[4096];
+	size_t n;
+	while((n = fread(buf, 1, sizeof(buf), f)) > 0)
+		data.insert(data.end(), buf, buf + n);
+	fclose(f);
+
+	auto wall = std::chrono::steady_clock::now();
+	uint32_t boots = 0, events = 0, flights = FlightLog_Count();
+	uint32_t base = 0, last = 0;
+	size_t pos = 0;
+
+	while(pos + sizeof(TraceHeader) <= data.size()) {
+		TraceHeader h;
+		memcpy(&h, &data[pos], sizeof(h));
+		if(h.magic != TRACE_MAGIC || h.version != TRACE_VERSION || h.size != sizeof(TraceEvent)) {
+			fprintf(stderr, "bad trace header at byte %zu\n", pos);
+			break;
+		}
+		pos += sizeof(h);
+		boots++;
+
+		bool first = true;
+		while(pos + sizeof(TraceEvent) <= data.size()) {
+			TraceEvent e;
+			memcpy(&e, &data[pos], sizeof(e));
+			if(e.ms == TRACE_MAGIC && e.us == (TRACE_VERSION | (sizeof(TraceEvent) << 8)))
+				break; /* the header of the next boot */
+			pos += sizeof(e);
+
+			if(first) {
+				base = millis() + 1000 - e.ms;
+				first = false;
+			} else if(maxGap && e.ms - last > maxGap) {
+				F3fStatus st;
+				F3F_Status(&st);
+				if(st.state == f3fIdle)
+					base -= e.ms - last - maxGap;
+			}
+			last = e.ms;
+			Sim_RunUntil(base + e.ms);
+			Native_Event(e.event, e.serNo);
+			events++;
+		}
+	}
+
+	Sim_Run(1000);
+	double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall).count();
+	fprintf(stderr, "%u boots, %u events, %u flights, %.1f s simulated in %.2f s, %.0fx\n", (unsigned)boots, (unsigned)events,
+		(unsigned)(FlightLog_Count() - flights), millis() / 1000.0, s, (millis() / 1000.0) / (s > 0 ? s : 1));
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	const char *replay = NULL;
+	bool latency = false;
+	uint32_t fuzz = 0;
+	std::vector<const char *> bench;
+	const char *scriptPath = NULL;
+	uint32_t maxGap = 0;
+
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "-q") == 0)
+			nativeQuiet = true;
+		else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+			replay = argv[++i];
+		else if(strcmp(argv[i], "-g") == 0 && i + 1 < argc)
+			maxGap = strtoul(argv[++i], NULL, 0);
+		else if(strcmp(argv[i], "-l") == 0)
+			latency = true;
+		else if(strcmp(argv[i], "-z") == 0 && i + 1 < argc)
+			fuzz = strtoul(argv[++i], NULL, 0);
+		else if(strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+			bench.push_back(argv[++i]);
+		else
+			scriptPath = argv[i];
+	}
+
+	FILE *script = scriptPath ? fopen(scriptPath, "r") : stdin;
+	uint32_t serNo = 0;
+
+	if(!replay && !latency && !fuzz && bench.empty() && !script) {
+		fprintf(stderr, "can not open %s\n", scriptPath);
+		return 1;
+	}
+
+	if(!bench.empty())
+		return Native_Bench(bench); /* no timer needed, stdout is the JSON only */
+
+	Log_Init();
+	lcd2004Setup();
+	FlightLog_Init();
+	Trace_Init();
+	Competition_Load(COMPETITION_PILOTS_PATH);
+	Anemometer_Init();
+	F3F_Init([](HeadLineType type) { Native_Trace("HEAD %d", type); });
+	xTaskCreatePinnedToCore(F3F_Task, "F3F_Task", 8192, NULL, configMAX_PRIORITIES - 1, NULL, 1);
+	Sim_Run(0);
+
+	if(replay)
+		Sim_Exit(Native_Replay(replay, maxGap));
+	if(fuzz)
+		Sim_Exit(Native_Fuzz(fuzz));
+	if(latency) {
+#ifdef LATENCY_BENCHMARK
+		Latency_Init();
+		while(!Latency_Done())
+			Sim_Run(1000);
+		Sim_Exit(0);
+#else
+		fprintf(stderr, "built without LATENCY_BENCHMARK\n");
+		Sim_Exit(1);
+#endif
+	}
+	char line[128];
+	while(fgets(line, sizeof(line), script)) {
+		unsigned long ms;
+		char event[16];
+		float speed;
+		unsigned dir;
+
+		if(line[0] == '#' || sscanf(line, "%lu %15s", &ms, event) != 2)
+			continue;
+		Sim_RunUntil(ms);
+
+		if(strcmp(event, "start") == 0)
+			F3F_KeyStart();
+		else if(strcmp(event, "stop") == 0)
+			F3F_KeyStop();
+		else if(strcmp(event, "a") == 0)
+			F3F_KeyA();
+		else if(strcmp(event, "b") == 0)
+			F3F_KeyB();
+		else if(strcmp(event, "baseA") == 0)
+			F3F_KeyBaseA();
+		else if(strcmp(event, "baseB") == 0)
+			F3F_KeyBaseB();
+		else if(strcmp(event, "remoteA") == 0)
+			F3F_TiggleBaseA(++serNo);
+		else if(strcmp(event, "remoteB") == 0)
+			F3F_TiggleBaseB(++serNo);
+		else if(strcmp(event, "wind") == 0 && sscanf(line, "%*u %*s %f %u", &speed, &dir) == 2)
+			Native_Wind(speed, dir);
+		else if(strcmp(event, "show") == 0)
+			Native_LcdDump();
+		else if(strcmp(event, "end") == 0)
+			break;
+		else
+			fprintf(stderr, "line ignored: %s", line);
+	}
+
+	Sim_Run(100); /* let the log and the flight log drain */
+	Native_LcdDump();
+	Sim_Exit(0);
+}
+
+#endif
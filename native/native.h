@@ -0,0 +1,17 @@
+/*
+ * native.h
+ *
+ * Trace of the native build, every line carries the virtual time.
+ */
+#ifndef NATIVE_H
+#define NATIVE_H
+
+#include <stdint.h>
+#include <vector>
+
+void Native_Trace(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+void Native_LcdDump();
+int Native_Fuzz(uint32_t iterations);
+int Native_Bench(const std::vector<const char *> &dirs);
+
+#endif
@@ -0,0 +1,62 @@
+#include <Arduino.h>
+#include "player.h"
+#include "native.h"
+#include "latency.h"
+
+/*
+* No audio on the host, a file is traced when it would start and counts as
+* played at once, so the priority rules of the real player do not apply.
+*/
+static uint8_t volume = 21;
+static char currentFile[64] = "";
+
+void Mp3Player_Init(void)
+{
+}
+
+void Mp3Player_Loop(void)
+{
+}
+
+void Mp3Player_Play(const char *filePath)
+{
+	snprintf(currentFile, sizeof(currentFile), "%s", filePath);
+	Native_Trace("PLAY %s", filePath);
+}
+
+void Mp3Player_PlayPriority(const char *filePath)
+{
+	snprintf(currentFile, sizeof(currentFile), "%s", filePath);
+	Native_Trace("PLAY! %s", filePath);
+	LATENCY_MARK(LATENCY_PLAY);
+	LATENCY_MARK(LATENCY_OPEN);
+	LATENCY_MARK(LATENCY_I2S);
+}
+
+void Mp3Player_Stop(void)
+{
+}
+
+void Mp3Player_Reset(void)
+{
+}
+
+bool Mp3Player_IsPlaying(void)
+{
+	return false;
+}
+
+const char *Mp3Player_CurrentPlayFile()
+{
+	return currentFile;
+}
+
+uint8_t Mp3Player_GetVolume()
+{
+	return volume;
+}
+
+void Mp3Player_SetVolume(uint8_t v)
+{
+	volume = v;
+}
@@ -0,0 +1,88 @@
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "SD.h"
+
+SDFS SD;
+
+/* not ./sdcard, the audio assets of the repository live there */
+static std::string SD_Root()
+{
+	const char *root = getenv("NATIVE_SD_ROOT");
+	if(root)
+		return root;
+	const char *tmp = getenv("TMPDIR");
+	return std::string(tmp ? tmp : "/tmp") + "/f3f_sdcard";
+}
+
+static std::string SD_HostPath(const char *path)
+{
+	std::string p = SD_Root();
+
+	::mkdir(p.c_str(), 0755);
+	if(path[0] != '/')
+		p += '/';
+	return p + path;
+}
+
+size_t File::size()
+{
+	if(!fp)
+		return 0;
+	long pos = ftell(fp);
+	fseek(fp, 0, SEEK_END);
+	long end = ftell(fp);
+	fseek(fp, pos, SEEK_SET);
+	return end;
+}
+
+int File::available()
+{
+	return fp ? (int)(size() - position()) : 0;
+}
+
+size_t File::readBytesUntil(char terminator, char *buf, size_t length)
+{
+	size_t n = 0;
+
+	while(n < length) {
+		int c = read();
+		if(c < 0 || c == terminator)
+			break;
+		buf[n++] = c;
+	}
+	return n;
+}
+
+/* "r+" keeps its meaning, the core modes are made binary */
+File SDFS::open(const char *path, const char *mode)
+{
+	std::string m = mode;
+
+	if(m.find('b') == std::string::npos)
+		m += 'b';
+	return File(fopen(SD_HostPath(path).c_str(), m.c_str()));
+}
+
+bool SDFS::exists(const char *path)
+{
+	struct stat st;
+	return stat(SD_HostPath(path).c_str(), &st) == 0;
+}
+
+bool SDFS::mkdir(const char *path)
+{
+	return ::mkdir(SD_HostPath(path).c_str(), 0755) == 0;
+}
+
+bool SDFS::remove(const char *path)
+{
+	return ::remove(SD_HostPath(path).c_str()) == 0;
+}
+
+bool SDFS::rename(const char *from, const char *to)
+{
+	return ::rename(SD_HostPath(from).c_str(), SD_HostPath(to).c_str()) == 0;
+}
@@ -0,0 +1,265 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "sim.h"
+
+#define SIM_FOREVER 0xffffffffffffffffULL
+
+struct SimQueue {
+	UBaseType_t length, itemSize;
+	std::deque<std::vector<uint8_t>> items;
+};
+
+struct SimTask {
+	const char *name;
+	TaskFunction_t fn;
+	void *arg;
+	UBaseType_t priority;
+	uint64_t wakeTick;          /* ready from this tick, SIM_FOREVER while waiting on a queue only */
+	SimQueue *waitQueue;        /* ready as soon as it has an item */
+	uint64_t lastRun;           /* round robin among equal priorities */
+	bool deleted;
+	std::condition_variable cv; /* its turn */
+};
+
+static std::mutex simMutex;
+static std::condition_variable simDriverCv;
+static SimTask *simCurrent = NULL;  /* NULL, the driver runs */
+static std::vector<SimTask *> simTasks;
+static uint64_t simTick = 0;        /* ms */
+static uint64_t simRuns = 0;
+
+uint64_t Sim_Micros()
+{
+	return simTick * 1000;
+}
+
+TickType_t xTaskGetTickCount()
+{
+	return (TickType_t)simTick;
+}
+
+static bool Sim_Ready(const SimTask *t)
+{
+	if(t->deleted)
+		return false;
+	if(t->waitQueue && !t->waitQueue->items.empty())
+		return true;
+	return t->wakeTick <= simTick;
+}
+
+/* Called by the driver, runs tasks until all of them wait for a later tick */
+static void Sim_Schedule()
+{
+	std::unique_lock<std::mutex> lock(simMutex);
+
+	for(;;) {
+		SimTask *next = NULL;
+		for(SimTask *t : simTasks) {
+			if(!Sim_Ready(t))
+				continue;
+			if(next == NULL || t->priority > next->priority ||
+					(t->priority == next->priority && t->lastRun < next->lastRun))
+				next = t;
+		}
+		if(next == NULL)
+			return;
+
+		next->lastRun = ++simRuns;
+		next->waitQueue = NULL;
+		simCurrent = next;
+		next->cv.notify_one();
+		simDriverCv.wait(lock, [] { return simCurrent == NULL; });
+	}
+}
+
+/* Called by a task, hands the turn back to the driver until the task is ready again */
+static void Sim_Block(std::unique_lock<std::mutex> &lock)
+{
+	SimTask *self = simCurrent;
+
+	simCurrent = NULL;
+	simDriverCv.notify_one();
+	self->cv.wait(lock, [self] { return simCurrent == self; });
+}
+
+static void Sim_TaskMain(SimTask *t)
+{
+	{
+		std::unique_lock<std::mutex> lock(simMutex);
+		t->cv.wait(lock, [t] { return simCurrent == t; });
+	}
+	t->fn(t->arg);
+	vTaskDelete(NULL);
+}
+
+void Sim_Run(uint32_t ms)
+{
+	Sim_Schedule(); /* whatever became ready from the driver */
+	while(ms--) {
+		simTick++;
+		Sim_Schedule();
+	}
+}
+
+void Sim_RunUntil(uint32_t ms)
+{
+	if(ms > simTick)
+		Sim_Run((uint32_t)(ms - simTick));
+	else
+		Sim_Run(0);
+}
+
+#ifdef NATIVE_COVERAGE
+/* built with --coverage, _Exit() leaves out the atexit() that writes the counts */
+extern "C" void __gcov_dump(void);
+#endif
+
+void Sim_Exit(int code)
+{
+	fflush(stdout);
+	fflush(stderr);
+#ifdef NATIVE_COVERAGE
+	__gcov_dump();
+#endif
+	_Exit(code); /* the task threads wait forever, do not run destructors under them */
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *arg,
+	UBaseType_t priority, TaskHandle_t *handle, BaseType_t core)
+{
+	(void)stackDepth;
+	(void)core;
+	return xTaskCreate(fn, name, 0, arg, priority, handle);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *arg,
+	UBaseType_t priority, TaskHandle_t *handle)
+{
+	(void)stackDepth;
+	SimTask *t = new SimTask;
+
+	t->name = name;
+	t->fn = fn;
+	t->arg = arg;
+	t->priority = priority;
+	t->wakeTick = 0;
+	t->waitQueue = NULL;
+	t->lastRun = 0;
+	t->deleted = false;
+
+	{
+		std::lock_guard<std::mutex> lock(simMutex);
+		simTasks.push_back(t);
+	}
+	std::thread(Sim_TaskMain, t).detach();
+	if(handle)
+		*handle = t;
+	return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+	std::unique_lock<std::mutex> lock(simMutex);
+	if(simCurrent == NULL) { /* the driver does not sleep, it runs the clock */
+		lock.unlock();
+		Sim_Run(ticks);
+		return;
+	}
+	simCurrent->wakeTick = simTick + (ticks ? ticks : 1); /* a yield waits a tick so a spinning task can not stall the clock */
+	Sim_Block(lock);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+	std::unique_lock<std::mutex> lock(simMutex);
+	SimTask *t = task ? task : simCurrent;
+
+	if(t == NULL)
+		return;
+	t->deleted = true;
+	if(t == simCurrent) {
+		for(;;)
+			Sim_Block(lock);
+	}
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+	return new SimQueue { length, itemSize, {} };
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+	(void)ticks; /* a full queue fails at once, nothing here waits for space */
+	std::lock_guard<std::mutex> lock(simMutex);
+
+	if(q->items.size() >= q->length)
+		return errQUEUE_FULL;
+	const uint8_t *p = (const uint8_t *)item;
+	if(q->itemSize)
+		q->items.emplace_back(p, p + q->itemSize);
+	else
+		q->items.emplace_back();
+	return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken)
+{
+	if(woken)
+		*woken = pdFALSE;
+	return xQueueSend(q, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks)
+{
+	std::unique_lock<std::mutex> lock(simMutex);
+
+	if(q->items.empty() && ticks != 0 && simCurrent != NULL) {
+		simCurrent->waitQueue = q;
+		simCurrent->wakeTick = (ticks == portMAX_DELAY) ? SIM_FOREVER : simTick + ticks;
+		Sim_Block(lock);
+	}
+	if(q->items.empty())
+		return pdFALSE;
+	if(q->itemSize)
+		memcpy(item, q->items.front().data(), q->itemSize);
+	q->items.pop_front();
+	return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+	std::lock_guard<std::mutex> lock(simMutex);
+	return q->items.size();
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q)
+{
+	std::lock_guard<std::mutex> lock(simMutex);
+	return q->length - q->items.size();
+}
+
+/* a mutex is a queue of one token */
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+	QueueHandle_t q = xQueueCreate(1, 0);
+	q->items.emplace_back();
+	return q;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks)
+{
+	uint8_t token;
+	return xQueueReceive(s, &token, ticks);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s)
+{
+	return xQueueSend(s, NULL, 0);
+}
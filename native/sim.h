@@ -0,0 +1,73 @@
+/*
+ * sim.h
+ *
+ * Virtual clock and FreeRTOS shim for env:native.
+ *
+ * Every task is a host thread but only one of them, or the driver, runs at a
+ * time. A task runs until it blocks in xQueueReceive(), xSemaphoreTake() or
+ * vTaskDelay(), then the highest priority ready task runs next. Time only moves
+ * in Sim_Run(), one tick at a time, so a run is the same on every host.
+ */
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* clock */
+uint64_t Sim_Micros();
+void Sim_Run(uint32_t ms);              /* advance the clock, running the tasks every tick */
+void Sim_RunUntil(uint32_t ms);         /* up to millis() == ms */
+void Sim_Exit(int code);                /* tasks never return, end the process from the driver */
+
+/* FreeRTOS */
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void *);
+typedef struct SimTask *TaskHandle_t;
+typedef struct SimQueue *QueueHandle_t;
+typedef QueueHandle_t xQueueHandle;
+typedef QueueHandle_t SemaphoreHandle_t;
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdPASS  pdTRUE
+#define pdFAIL  pdFALSE
+#define errQUEUE_FULL 0
+
+#define configTICK_RATE_HZ 1000
+#define configMAX_PRIORITIES 25
+#define portMAX_DELAY ((TickType_t)0xffffffff)
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms) * configTICK_RATE_HZ / 1000)
+
+/* one thing runs at a time, critical sections have nothing to exclude */
+typedef struct { int unused; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+#define portENTER_CRITICAL(mux) (void)(mux)
+#define portEXIT_CRITICAL(mux) (void)(mux)
+#define portENTER_CRITICAL_ISR(mux) (void)(mux)
+#define portEXIT_CRITICAL_ISR(mux) (void)(mux)
+#define portYIELD_FROM_ISR(...) do {} while(0)
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *arg,
+	UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *arg,
+	UBaseType_t priority, TaskHandle_t *handle);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelete(TaskHandle_t task);
+TickType_t xTaskGetTickCount();
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks);
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken);
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q);
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s);
+
+#endif
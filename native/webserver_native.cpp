@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "WebServer.h"
+
+WebServer *WebServer::nativeServer = NULL;
+
+long WebServerArg::toInt() const
+{
+	return strtol(value.c_str(), NULL, 10);
+}
+
+bool WiFiClient::connected()
+{
+	return server->nativeConnected();
+}
+
+WebServer::WebServer(int port)
+{
+	(void)port;
+	nativeServer = this;
+}
+
+void WebServer::on(const char *uri, int method, std::function<void()> handler)
+{
+	(void)method;
+	routes.push_back({ uri, handler });
+}
+
+void WebServer::nativeRequest(const char *uri, size_t drop)
+{
+	const char *q = strchr(uri, '?');
+
+	pendingUri = q ? std::string(uri, q - uri) : std::string(uri);
+	query = q ? q + 1 : "";
+	dropAfter = drop;
+	sent = offered = 0;
+}
+
+std::string WebServer::nativeResponse()
+{
+	std::string r;
+
+	r.swap(response);
+	return r;
+}
+
+/* one request per call, as the core serves one client at a time */
+void WebServer::handleClient()
+{
+	if(pendingUri.empty())
+		return;
+
+	std::string uri;
+	uri.swap(pendingUri);
+	headers.clear();
+	contentLength = CONTENT_LENGTH_NOT_SET;
+	chunked = false;
+	for(const Route &r : routes) {
+		if(r.uri == uri) {
+			r.handler();
+			return;
+		}
+	}
+	send(404, "text/plain", ("Not found: " + uri).c_str());
+}
+
+bool WebServer::hasArg(const char *name)
+{
+	std::string key = std::string(name) + "=";
+
+	for(size_t pos = 0; pos < query.size();) {
+		if(query.compare(pos, key.size(), key) == 0)
+			return true;
+		size_t amp = query.find('&', pos);
+		pos = (amp == std::string::npos) ? query.size() : amp + 1;
+	}
+	return false;
+}
+
+WebServerArg WebServer::arg(const char *name)
+{
+	std::string key = std::string(name) + "=";
+
+	for(size_t pos = 0; pos < query.size();) {
+		size_t amp = query.find('&', pos);
+		size_t end = (amp == std::string::npos) ? query.size() : amp;
+		if(query.compare(pos, key.size(), key) == 0)
+			return WebServerArg(query.substr(pos + key.size(), end - pos - key.size()));
+		pos = end + 1;
+	}
+	return WebServerArg("");
+}
+
+void WebServer::sendHeader(const char *name, const char *value, bool first)
+{
+	std::string line = std::string(name) + ": " + value + "\r\n";
+
+	headers = first ? line + headers : headers + line;
+}
+
+void WebServer::write(const char *p, size_t len)
+{
+	offered += len;
+	if(sent >= dropAfter)
+		return;
+	if(len > dropAfter - sent)
+		len = dropAfter - sent;
+	response.append(p, len);
+	sent += len;
+}
+
+/* the status line and headers of WebServer::_prepareHeader() of the core */
+void WebServer::send(int code, const char *type, const char *content)
+{
+	char line[64];
+	size_t len = strlen(content);
+
+	snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\n", code, (code == 200) ? "OK" : (code == 404) ? "Not Found" : "");
+	sendHeader("Content-Type", type, true);
+	if(contentLength == CONTENT_LENGTH_NOT_SET) {
+		char n[16];
+		snprintf(n, sizeof(n), "%u", (unsigned)len);
+		sendHeader("Content-Length", n);
+	} else if(contentLength == CONTENT_LENGTH_UNKNOWN) {
+		chunked = true;
+		sendHeader("Accept-Ranges", "none");
+		sendHeader("Transfer-Encoding", "chunked");
+	}
+	sendHeader("Connection", "close");
+
+	std::string head = line + headers + "\r\n";
+	headers.clear();
+	write(head.data(), head.size());
+	if(len)
+		sendContent(content, len);
+}
+
+void WebServer::sendContent(const char *content, size_t len)
+{
+	if(chunked) {
+		char size[16];
+		snprintf(size, sizeof(size), "%x\r\n", (unsigned)len);
+		write(size, strlen(size));
+	}
+	write(content, len);
+	if(chunked) {
+		write("\r\n", 2);
+		if(len == 0)
+			chunked = false;
+	}
+}
+
+void WebServer::sendContent(const char *content)
+{
+	sendContent(content, strlen(content));
+}
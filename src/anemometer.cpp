@@ -0,0 +1,117 @@
+#include <Arduino.h>
+#include <math.h>
+#include "anemometer.h"
+#include "modbus.h"
+#include "wind.h"
+#include "f3f.h"
+#include "log.h"
+#include "telemetry.h"
+
+/*
+* The anemometer answers a read of its registers with a MODBUS-ASCII frame,
+* address 1, function 3, 6 data bytes: direction as a 16 bit register and the
+* speed in m/s as a float with its low word first. Out of range readings come
+* as the text lines ":OOR:1" (speed) and ":OOR:2" (direction).
+*
+* The producer only parses and queues, anemometerTask applies the samples at
+* low priority on core 0, away from the F3F timing task.
+*/
+#define ANEMOMETER_QUEUE_SIZE 8
+#define ANEMOMETER_ADDR       1
+#define ANEMOMETER_FUNC       3
+#define ANEMOMETER_DATA_LEN   6
+
+static ModbusAscii anemometerParser;
+static QueueHandle_t anemometerQueue = NULL;
+static volatile uint32_t anemometerDropped = 0;
+static volatile uint32_t anemometerErrors = 0;
+
+bool Anemometer_Decode(const ModbusAscii *m, ModbusResult r, uint32_t tick, AnemometerSample *s)
+{
+	memset(s, 0, sizeof(AnemometerSample));
+	s->tick = tick;
+
+	if(r == modbusText) {
+		if(m->len == 5 && memcmp(m->data, "OOR:1", 5) == 0)
+			s->status = ANEMOMETER_SPEED_OOR;
+		else if(m->len == 5 && memcmp(m->data, "OOR:2", 5) == 0)
+			s->status = ANEMOMETER_DIR_OOR;
+		else
+			return false;
+		return true;
+	}
+
+	const uint8_t *d = m->data;
+	if(m->len != 3 + ANEMOMETER_DATA_LEN || d[0] != ANEMOMETER_ADDR || d[1] != ANEMOMETER_FUNC || d[2] != ANEMOMETER_DATA_LEN)
+		return false;
+
+	uint16_t dir = (d[3] << 8) | d[4];
+	uint32_t bits = ((uint32_t)d[7] << 24) | ((uint32_t)d[8] << 16) | ((uint32_t)d[5] << 8) | d[6];
+	float speed;
+	memcpy(&speed, &bits, sizeof(speed));
+
+	if(dir >= 360 || !isfinite(speed) || speed < 0 || speed * 100 > 0xffff)
+		return false;
+
+	s->dir = dir;
+	s->speed = (uint16_t)lroundf(speed * 100);
+	s->status = ANEMOMETER_OK;
+	return true;
+}
+
+void Anemometer_Feed(const uint8_t *data, size_t len)
+{
+	AnemometerSample s;
+
+	for(size_t i = 0; i < len; i++) {
+		ModbusResult r = ModbusAscii_Feed(&anemometerParser, data[i]);
+		if(r == modbusNone)
+			continue;
+		if(r == modbusError || !Anemometer_Decode(&anemometerParser, r, millis(), &s)) {
+			anemometerErrors++;
+			continue;
+		}
+		if(anemometerQueue == NULL || xQueueSend(anemometerQueue, &s, 0) != pdTRUE)
+			anemometerDropped++;
+		else
+			Telemetry_QueueSent(anemometerQueue);
+	}
+}
+
+static void anemometerTask(void *pvParameters)
+{
+	AnemometerSample s;
+	uint32_t dropped = 0;
+
+	while(1) {
+		if(xQueueReceive(anemometerQueue, &s, portMAX_DELAY) != pdTRUE)
+			continue;
+		if(s.status == ANEMOMETER_OK)
+			Wind_Add(s.tick, s.speed, s.dir);
+		F3F_WindSample(s.status);
+
+		if(dropped != anemometerDropped) {
+			LOG_W("%u anemometer samples dropped", (unsigned)(anemometerDropped - dropped));
+			dropped = anemometerDropped;
+		}
+	}
+}
+
+void Anemometer_Init()
+{
+	ModbusAscii_Reset(&anemometerParser);
+
+	anemometerQueue = xQueueCreate(ANEMOMETER_QUEUE_SIZE, sizeof(AnemometerSample));
+	Telemetry_Queue("anemometer", anemometerQueue);
+	xTaskCreatePinnedToCore(anemometerTask, "anemometerTask", 3072, NULL, 1, NULL, 0);
+}
+
+uint32_t Anemometer_Dropped()
+{
+	return anemometerDropped;
+}
+
+uint32_t Anemometer_Errors()
+{
+	return anemometerErrors;
+}
@@ -0,0 +1,34 @@
+#ifndef ANEMOMETER_H
+#define ANEMOMETER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "modbus.h"
+
+#define ANEMOMETER_OK        0
+#define ANEMOMETER_SPEED_OOR 1  /* ":OOR:1", wind speed out of range */
+#define ANEMOMETER_DIR_OOR   2  /* ":OOR:2", wind direction out of range */
+
+typedef struct {
+	uint32_t tick;          /* millis() when the frame was complete */
+	uint16_t speed;         /* cm/s */
+	uint16_t dir;           /* degrees */
+	uint8_t status;         /* ANEMOMETER_xxx */
+} AnemometerSample;
+
+void Anemometer_Init();
+
+/*
+* Raw bytes of the anemometer feed in any chunks, from a single producer (the
+* UDP receive callback). Never blocks, samples are queued to a low priority task
+* that updates the wind statistics and the display.
+*/
+void Anemometer_Feed(const uint8_t *data, size_t len);
+
+/* A frame or text line of the parser to a sample, false if the anemometer does not send it */
+bool Anemometer_Decode(const ModbusAscii *m, ModbusResult r, uint32_t tick, AnemometerSample *s);
+
+uint32_t Anemometer_Dropped();  /* samples lost to a full queue */
+uint32_t Anemometer_Errors();   /* frames with a bad LRC, character or length */
+
+#endif
@@ -0,0 +1,217 @@
+#include <Arduino.h>
+#include <SD.h>
+#include "competition.h"
+#include "log.h"
+
+/*
+* F3F scoring, in every round the fastest time gets 1000 points and the others
+* 1000 * fastest / time. The worst rounds of each pilot are discarded once enough
+* rounds are complete.
+*
+* Standings are kept up to date per flight instead of being recomputed. A new
+* time only changes its own round: either one pilot gets a score, or the round
+* has a new fastest time and the scores of its pilots go down. Each pilot keeps
+* the sum of its scores and its lowest ones, and a score that only goes down
+* never needs a look at the other rounds, so a flight costs O(pilots).
+*/
+#define COMPETITION_DISCARDS_MAX 2
+
+typedef struct {
+	char name[COMPETITION_NAME_SIZE];
+	uint32_t sum;                           /* all round scores */
+	uint32_t low[COMPETITION_DISCARDS_MAX]; /* lowest scores, ascending */
+	uint8_t nlow;
+	uint32_t net;                           /* sum without the discarded rounds */
+} Pilot;
+
+static Pilot pilots[COMPETITION_MAX_PILOTS];
+static uint8_t pilotCount = 0;
+static uint32_t flightTimes[COMPETITION_MAX_ROUNDS][COMPETITION_MAX_PILOTS]; /* ms, 0 not flown */
+static uint32_t roundBest[COMPETITION_MAX_ROUNDS];
+static uint8_t rank[COMPETITION_MAX_PILOTS];    /* pilot index by standing */
+
+static uint8_t currentRound = 0;    /* 0 based */
+static uint8_t currentSlot = 0;     /* position in the flight order of the round */
+static uint8_t roundsDone = 0;
+
+static uint32_t Competition_Score(uint32_t best, uint32_t t)
+{
+	return t ? (uint32_t)((100000ULL * best) / t) : 0;
+}
+
+/* FAI F3F, one discard from 4 complete rounds, a second one from 15 */
+static uint8_t Competition_Discards()
+{
+	if(roundsDone >= 15)
+		return 2;
+	if(roundsDone >= 4)
+		return 1;
+	return 0;
+}
+
+static void Competition_Net(Pilot *p)
+{
+	uint32_t net = p->sum;
+
+	for(uint8_t i = 0; i < Competition_Discards() && i < p->nlow; i++)
+		net -= p->low[i];
+	p->net = net;
+}
+
+static void Competition_LowInsert(Pilot *p, uint32_t s)
+{
+	int i;
+
+	if(p->nlow == COMPETITION_DISCARDS_MAX) {
+		if(s >= p->low[COMPETITION_DISCARDS_MAX - 1])
+			return;
+		p->nlow--; /* the largest drops out */
+	}
+	for(i = p->nlow; i > 0 && p->low[i - 1] > s; i--)
+		p->low[i] = p->low[i - 1];
+	p->low[i] = s;
+	p->nlow++;
+}
+
+/* A score of the pilot went from old down to s */
+static void Competition_Lower(Pilot *p, uint32_t old, uint32_t s)
+{
+	p->sum = p->sum - old + s;
+	for(uint8_t i = 0; i < p->nlow; i++) {
+		if(p->low[i] == old) { /* still among the lowest, only the order can change */
+			for(; i > 0 && p->low[i - 1] > s; i--)
+				p->low[i] = p->low[i - 1];
+			p->low[i] = s;
+			return;
+		}
+	}
+	Competition_LowInsert(p, s);
+}
+
+/* Standings are nearly sorted after a flight, insertion sort is O(pilots) then */
+static void Competition_Rank()
+{
+	for(int i = 1; i < pilotCount; i++) {
+		uint8_t r = rank[i];
+		int j = i;
+		for(; j > 0 && pilots[rank[j - 1]].net < pilots[r].net; j--)
+			rank[j] = rank[j - 1];
+		rank[j] = r;
+	}
+}
+
+static uint8_t Competition_PilotOf(uint8_t r, uint8_t s)
+{
+	return (s + r) % pilotCount; /* the draw order starts one pilot later every round */
+}
+
+bool Competition_Load(const char *path)
+{
+	File f = SD.open(path, FILE_READ);
+	if(!f)
+		return false;
+
+	memset(pilots, 0, sizeof(pilots));
+	memset(flightTimes, 0, sizeof(flightTimes));
+	memset(roundBest, 0, sizeof(roundBest));
+	pilotCount = 0;
+	currentRound = currentSlot = roundsDone = 0;
+
+	char line[64];
+	while(f.available() && pilotCount < COMPETITION_MAX_PILOTS) {
+		size_t n = f.readBytesUntil('\n', line, sizeof(line) - 1);
+		while(n && (line[n - 1] == '\r' || line[n - 1] == ' '))
+			n--;
+		line[n] = 0;
+		if(n == 0 || line[0] == '#')
+			continue;
+		strncpy(pilots[pilotCount].name, line, COMPETITION_NAME_SIZE - 1);
+		rank[pilotCount] = pilotCount;
+		pilotCount++;
+	}
+	f.close();
+
+	LOG_I("Competition %u pilots", pilotCount);
+	return pilotCount > 0;
+}
+
+bool Competition_Active()
+{
+	return pilotCount > 0 && currentRound < COMPETITION_MAX_ROUNDS;
+}
+
+uint8_t Competition_Round()
+{
+	return currentRound + 1;
+}
+
+const char *Competition_CurrentPilot()
+{
+	if(!Competition_Active())
+		return "";
+	return pilots[Competition_PilotOf(currentRound, currentSlot)].name;
+}
+
+/* The next pilot, the next round after the last one */
+static void Competition_Advance()
+{
+	if(++currentSlot >= pilotCount) {
+		currentSlot = 0;
+		currentRound++;
+		roundsDone++;
+	}
+
+	for(uint8_t i = 0; i < pilotCount; i++) /* the discard count may have changed */
+		Competition_Net(&pilots[i]);
+	Competition_Rank();
+}
+
+void Competition_NoFlight()
+{
+	if(!Competition_Active())
+		return;
+
+	uint8_t pi = Competition_PilotOf(currentRound, currentSlot);
+
+	/* the time stays 0, a faster time in the round never changes this score */
+	Competition_LowInsert(&pilots[pi], 0);
+	LOG_I("Round %u %s no flight", currentRound + 1, pilots[pi].name);
+	Competition_Advance();
+}
+
+void Competition_FlightDone(uint32_t time_ms)
+{
+	if(!Competition_Active())
+		return;
+	if(time_ms == 0) {
+		Competition_NoFlight();
+		return;
+	}
+
+	uint8_t pi = Competition_PilotOf(currentRound, currentSlot);
+	uint32_t *t = flightTimes[currentRound];
+	uint32_t best = roundBest[currentRound];
+
+	t[pi] = time_ms;
+	if(best == 0 || time_ms < best) { /* new fastest time, the others in the round go down */
+		for(uint8_t i = 0; i < pilotCount; i++) {
+			if(t[i] && i != pi)
+				Competition_Lower(&pilots[i], Competition_Score(best, t[i]), Competition_Score(time_ms, t[i]));
+		}
+		roundBest[currentRound] = best = time_ms;
+	}
+	pilots[pi].sum += Competition_Score(best, time_ms);
+	Competition_LowInsert(&pilots[pi], Competition_Score(best, time_ms));
+
+	LOG_I("Round %u %s %u.%02u s", currentRound + 1, pilots[pi].name, (unsigned)(time_ms / 1000), (unsigned)(time_ms % 1000) / 10);
+	Competition_Advance();
+}
+
+bool Competition_Standing(uint8_t r, const char **name, uint32_t *points)
+{
+	if(r >= pilotCount)
+		return false;
+	*name = pilots[rank[r]].name;
+	*points = pilots[rank[r]].net;
+	return true;
+}
@@ -0,0 +1,27 @@
+#ifndef COMPETITION_H
+#define COMPETITION_H
+
+#include <stdint.h>
+
+#define COMPETITION_PILOTS_PATH "/f3f/pilots.txt"  /* one pilot name per line, in draw order */
+
+#define COMPETITION_MAX_PILOTS 48
+#define COMPETITION_MAX_ROUNDS 20
+#define COMPETITION_NAME_SIZE  16
+
+bool Competition_Load(const char *path);
+bool Competition_Active();
+
+uint8_t Competition_Round();            /* 1 based */
+const char *Competition_CurrentPilot();
+
+/* Score the finished flight of the current pilot and move to the next one */
+void Competition_FlightDone(uint32_t time_ms);
+
+/* The current pilot did not fly or landed out, 0 points, the next pilot is up */
+void Competition_NoFlight();
+
+/* rank is 0 based, points are in 1/100 */
+bool Competition_Standing(uint8_t rank, const char **name, uint32_t *points);
+
+#endif
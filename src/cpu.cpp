@@ -0,0 +1,157 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "cpu.h"
+
+/*
+* The run time counters of the tasks only ever grow, a window is the difference
+* of two snapshots. A task is matched to its previous counter by handle, one that
+* was created in the window counts from 0. The loop marks run in their own
+* task, cpuTask reads and clears the maximum without a lock, a pass that ends
+* just then can go to either window.
+*/
+static int64_t loopLast[CPU_LOOPS];
+static volatile uint32_t loopMax[CPU_LOOPS];
+
+static CpuStats cpuStats;
+static portMUX_TYPE cpuMux = portMUX_INITIALIZER_UNLOCKED;
+
+void Cpu_LoopMark(uint8_t loop)
+{
+	int64_t t = esp_timer_get_time();
+
+	if(loopLast[loop]) {
+		uint32_t d = (uint32_t)(t - loopLast[loop]);
+		if(d > loopMax[loop])
+			loopMax[loop] = d;
+	}
+	loopLast[loop] = t;
+}
+
+#if configGENERATE_RUN_TIME_STATS
+typedef struct {
+	TaskHandle_t handle;
+	configRUN_TIME_COUNTER_TYPE counter;
+} CpuCounter;
+
+static TaskStatus_t cpuStatus[CPU_TASKS_MAX];
+static CpuCounter cpuLast[CPU_TASKS_MAX];
+static uint8_t cpuLastCount = 0;
+static configRUN_TIME_COUNTER_TYPE cpuLastTotal = 0;
+
+static configRUN_TIME_COUNTER_TYPE Cpu_LastCounter(TaskHandle_t handle)
+{
+	for(uint8_t i = 0; i < cpuLastCount; i++) {
+		if(cpuLast[i].handle == handle)
+			return cpuLast[i].counter;
+	}
+	return 0;
+}
+
+static void Cpu_Sample(CpuStats *s)
+{
+	configRUN_TIME_COUNTER_TYPE total;
+	UBaseType_t n = uxTaskGetSystemState(cpuStatus, CPU_TASKS_MAX, &total);
+	configRUN_TIME_COUNTER_TYPE window = total - cpuLastTotal;
+
+	for(uint8_t c = 0; c < CPU_CORES; c++)
+		s->idle[c] = CPU_UNKNOWN;
+	s->tasks = 0;
+	if(n == 0 || window == 0)
+		return; /* more tasks than CPU_TASKS_MAX, or no time passed */
+
+	for(UBaseType_t i = 0; i < n; i++) {
+		TaskStatus_t *ts = &cpuStatus[i];
+		CpuTask *t = &s->task[s->tasks++];
+		configRUN_TIME_COUNTER_TYPE busy = ts->ulRunTimeCounter - Cpu_LastCounter(ts->xHandle);
+		uint32_t permille = (uint32_t)((uint64_t)busy * 1000 / window);
+
+		snprintf(t->name, sizeof(t->name), "%s", ts->pcTaskName);
+#if configTASKLIST_INCLUDE_COREID
+		t->core = (ts->xCoreID < CPU_CORES) ? ts->xCoreID : -1;
+#else
+		t->core = -1;
+#endif
+		t->prio = ts->uxCurrentPriority;
+		t->permille = (permille > 1000) ? 1000 : permille;
+
+		for(uint8_t c = 0; c < CPU_CORES; c++) {
+			if(ts->xHandle == xTaskGetIdleTaskHandleForCore(c))
+				s->idle[c] = t->permille / 10;
+		}
+	}
+
+	for(UBaseType_t i = 0; i < n; i++) {
+		cpuLast[i].handle = cpuStatus[i].xHandle;
+		cpuLast[i].counter = cpuStatus[i].ulRunTimeCounter;
+	}
+	cpuLastCount = n;
+	cpuLastTotal = total;
+}
+#else
+static void Cpu_Sample(CpuStats *s)
+{
+	for(uint8_t c = 0; c < CPU_CORES; c++)
+		s->idle[c] = CPU_UNKNOWN;
+	s->tasks = 0;
+}
+#endif
+
+static void cpuTask(void *pvParameters)
+{
+	static CpuStats s; /* off the stack, cpuTask is small */
+
+	for(;;) {
+		vTaskDelay(pdMS_TO_TICKS(CPU_WINDOW_MS));
+		Cpu_Sample(&s);
+		for(uint8_t i = 0; i < CPU_LOOPS; i++) {
+			s.loopMax[i] = loopMax[i];
+			loopMax[i] = 0;
+		}
+
+		portENTER_CRITICAL(&cpuMux);
+		cpuStats = s;
+		portEXIT_CRITICAL(&cpuMux);
+	}
+}
+
+void Cpu_Init()
+{
+	for(uint8_t c = 0; c < CPU_CORES; c++)
+		cpuStats.idle[c] = CPU_UNKNOWN;
+	xTaskCreatePinnedToCore(cpuTask, "cpuTask", 3072, NULL, 1, NULL, 0);
+}
+
+void Cpu_Stats(CpuStats *s)
+{
+	portENTER_CRITICAL(&cpuMux);
+	*s = cpuStats;
+	portEXIT_CRITICAL(&cpuMux);
+}
+
+void Cpu_Dump()
+{
+	static CpuStats s;
+	uint8_t order[CPU_TASKS_MAX];
+
+	Cpu_Stats(&s);
+	for(uint8_t i = 0; i < s.tasks; i++) { /* insertion sort, busiest first */
+		uint8_t j = i;
+		for(; j > 0 && s.task[order[j - 1]].permille < s.task[i].permille; j--)
+			order[j] = order[j - 1];
+		order[j] = i;
+	}
+
+	Serial.printf("cpu idle");
+	for(uint8_t c = 0; c < CPU_CORES; c++) {
+		if(s.idle[c] == CPU_UNKNOWN)
+			Serial.printf(" %u:-", c);
+		else
+			Serial.printf(" %u:%u%%", c, s.idle[c]);
+	}
+	Serial.printf(", loop max %u us, F3F_Task max %u us\r\n", (unsigned)s.loopMax[CPU_LOOP_MAIN], (unsigned)s.loopMax[CPU_LOOP_F3F]);
+	for(uint8_t i = 0; i < s.tasks; i++) {
+		const CpuTask *t = &s.task[order[i]];
+		Serial.printf("%-16s %c %2u %3u.%u%%\r\n", t->name, (t->core < 0) ? '*' : '0' + t->core, t->prio,
+			t->permille / 10, t->permille % 10);
+	}
+}
@@ -0,0 +1,40 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdint.h>
+
+/*
+* CPU load from the FreeRTOS run time statistics, sampled once a window by a low
+* priority task: the busy share of every task and the idle share of every core.
+* loop() and F3F_Task mark every pass, the longest period in the window shows
+* how late either of them can be to a base event.
+*/
+#define CPU_WINDOW_MS 1000
+#define CPU_TASKS_MAX 24
+#define CPU_CORES     2
+#define CPU_UNKNOWN   0xff      /* idle, built without run time statistics */
+
+#define CPU_LOOP_MAIN 0         /* loop(), core 1 */
+#define CPU_LOOP_F3F  1         /* F3F_Task, core 1 */
+#define CPU_LOOPS     2
+
+typedef struct {
+	char name[16];
+	int8_t core;                /* -1 either core */
+	uint8_t prio;
+	uint16_t permille;          /* of one core */
+} CpuTask;
+
+typedef struct {
+	uint8_t idle[CPU_CORES];    /* % */
+	uint32_t loopMax[CPU_LOOPS]; /* us */
+	uint8_t tasks;
+	CpuTask task[CPU_TASKS_MAX];
+} CpuStats;
+
+void Cpu_Init();
+void Cpu_LoopMark(uint8_t loop);    /* every pass, one task per loop */
+void Cpu_Stats(CpuStats *s);        /* the last full window */
+void Cpu_Dump();                    /* the last window to the serial port, busiest task first */
+
+#endif
@@ -1,5 +1,14 @@
 #include <Arduino.h>
 #include "f3f.h"
+#include "log.h"
+#include "flightlog.h"
+#include "competition.h"
+#include "wind.h"
+#include "anemometer.h"
+#include "trace.h"
+#include "latency.h"
+#include "cpu.h"
+#include "telemetry.h"
 
 xQueueHandle keyPressQueue;
 
@@ -121,7 +130,15 @@ enum { KEY_0, KEY_1, KEY_2, KEY_3,
     KEY_4, KEY_5, KEY_6, KEY_7, 
     KEY_8, KEY_9, KEY_A, KEY_B, 
     KEY_C, KEY_D, KEY_STAR, KEY_SHARP,
-    KEY_START, KEY_STOP, KEY_BASE_A, KEY_BASE_B, KEY_MAX };
+    KEY_START, KEY_STOP, KEY_BASE_A, KEY_BASE_B, KEY_WIND, KEY_MAX };
+
+#define KEY_REMOTE 0x80 /* base event from the radio or the network */
+
+typedef struct {
+    uint8_t key;
+    uint32_t tick; /* millis() when the event was captured, not when it is handled */
+    uint8_t alerts; /* KEY_WIND, WIND_ALERT_xxx of the last sample */
+} KeyEvent;
   
 #define MUTEX_UNLOCK 0
 #define MUTEX_LOCK 1
@@ -203,6 +220,7 @@ F3F_State *currentState = &idleState;
 
 const char strBlank[] = "                    ";
 static char strLastRecord[11] = "XXXXXXXXXX";
+static uint32_t lastRecordMs = 0;
   
 static uint8_t keypadMap[4][4] = {
     { KEY_1, KEY_2, KEY_3, KEY_A },
@@ -213,7 +231,7 @@ static uint8_t keypadMap[4][4] = {
   
 static void F3F_StateOnKey(uint8_t row, uint8_t col, uint32_t ms_tick)
 {
-    Serial.printf("KEY %d\r\n", keypadMap[col][row]);
+    LOG_I("KEY %d", keypadMap[col][row]);
     currentState->OnKey(keypadMap[col][row], ms_tick);
 }
   
@@ -224,7 +242,7 @@ static void F3F_StateOnKey(uint8_t row, uint8_t col, uint32_t ms_tick)
 #include "player.h"
 #include "lcd204.h"
 
-static HeadLineType s_headLine = showCpuUsage;
+static HeadLineType s_headLine = showWifi;
 static void (*s_headLineCb)(HeadLineType type) = nullptr;
 
 /*
@@ -237,6 +255,9 @@ static uint32_t serNoB = 0;
 
 static bool canBeReFlight = false;
 
+static uint8_t baseSource = FLIGHT_SRC_WIRED; /* source of the base event being handled */
+static FlightRecord flightRecord;
+
 const char strPressStart[] = "Press Start";
 const char strReady[] = "Ready";
 
@@ -246,7 +267,10 @@ static void IdleState_OnEnter(uint32_t ms_tick)
   MsTimer_Reset(&stateTimer);
 
   lcdPrintRow(2, strPressStart);
-  lcdPrintRow(3, strReady);
+  if(F3F_Mode() == f3fCompetition && Competition_Active())
+    lcdPrintRow(3, "R%u %s", Competition_Round(), Competition_CurrentPilot());
+  else
+    lcdPrintRow(3, strReady);
 }
 
 static void IdleState_OnLoop()
@@ -274,17 +298,17 @@ static void IdleState_OnKey(uint8_t key, uint32_t ms_tick)
         int i = s_headLine;
         s_headLine = static_cast<HeadLineType>(++i);
         if(s_headLine >= showMaximum)
-        s_headLine = showCpuUsage;       
+        s_headLine = showWifi;       
         if(s_headLineCb) {
           s_headLineCb(s_headLine);
         }
         }  break;
     case KEY_BASE_A: 
-        if(s_headLine == showCpuUsage) 
+        if(s_headLine == showWifi) 
           lcdPrintRow(0, "<A%04d>", serNoA);
         break;
     case KEY_BASE_B: 
-        if(s_headLine == showCpuUsage) 
+        if(s_headLine == showWifi) 
           lcdPrintRow(0, "<B%04d>", serNoB);
         break;
     case KEY_A:
@@ -315,6 +339,14 @@ static void IdleState_OnKey(uint8_t key, uint32_t ms_tick)
               Mp3Player_SetVolume(Mp3Player_GetVolume() - 1);
             lcdPrintRow(0, "Volume : %d dbm", Mp3Player_GetVolume());
             break;
+          case showStandings: /* the pilot up did not fly or landed out, 0 points */
+            if(F3F_Mode() == f3fCompetition && Competition_Active()) {
+              Competition_NoFlight();
+              currentState->OnEnter(ms_tick);
+              if(s_headLineCb)
+                s_headLineCb(s_headLine);
+            }
+            break;
           default: 
             break;
         } break;
@@ -337,8 +369,6 @@ static void IdleState_OnInterval(uint32_t time_ms)
 
 /**/
 
-const char strOutSide[] = "Out side";
-const char strThirtySecond[] = "30 Seconds";
 static bool thirtySecondOutSide = false;
 static bool thirtySecondTimeOut = false;
 
@@ -346,13 +376,14 @@ static void ThirtySecondState_OnEnter(uint32_t ms_tick)
 {
   thirtySecondOutSide = false;
   thirtySecondTimeOut = false;
+  Wind_FlightStart();
 
   MsTimer_Reset(&stateTimer);
   MsTimer_SetupInterval(&stateTimer, 10, ThirtySecondState_OnInterval); /* 10 ms interval */
   MsTimer_Start(&stateTimer, 30000, ThirtySecondState_OnTimeout); /* 30 seconds */
 
-  lcdPrintRow(2, strThirtySecond);
-  lcdPrintRow(3, strBlank);
+  lcdBigLabel("30s", "");
+  lcdBigTime(30000);
 }
 
 static void ThirtySecondState_OnLoop()
@@ -376,7 +407,7 @@ static void ThirtySecondState_OnKey(uint8_t key, uint32_t ms_tick)
         currentState = &courseState;
         currentState->OnEnter(ms_tick);
       } else {
-        lcdPrintRow(2, strOutSide);
+        lcdBigLabel("Out", "side");
         Mp3Player_PlayPriority("vocal/outside.mp3");
         thirtySecondOutSide = true;
       }
@@ -398,9 +429,8 @@ static void ThirtySecondState_OnInterval(uint32_t time_ms)
   static uint32_t sec = 0;
   uint32_t t = 30000 - time_ms;
   uint32_t s = t / 1000;
-  uint32_t ms = t % 1000;
 
-  lcdPrintRow(3, "               %2u.%02u", s, ms / 10);
+  lcdBigTime(t);
 /*
   if(ms != 0)
     return;
@@ -442,9 +472,66 @@ static void ThirtySecondState_OnInterval(uint32_t time_ms)
 char strBuf[16];
 static uint8_t courseProgressCount = 0;
 
+#ifndef F3F_LEG_CALLOUT
+#define F3F_LEG_CALLOUT 0 /* 1: announce the whole seconds of every leg */
+#endif
+
+/* Duration of leg n (1 based) from the split table, 0 if not flown */
+static uint32_t CourseLegTime(uint8_t n)
+{
+  if(n < 1 || n > flightRecord.legs)
+    return 0;
+  return flightRecord.split_ms[n - 1] - ((n > 1) ? flightRecord.split_ms[n - 2] : 0);
+}
+
+static void CourseLabel()
+{
+  char strLeg[8] = "";
+  uint32_t t = CourseLegTime(flightRecord.legs);
+
+  snprintf(strBuf, 16, "C%3d", courseProgressCount);
+  if(t) { /* last leg time in 4 cells */
+    if(t < 10000)
+      snprintf(strLeg, sizeof(strLeg), "%u.%02u", (unsigned)(t / 1000), (unsigned)(t % 1000) / 10);
+    else if(t < 100000)
+      snprintf(strLeg, sizeof(strLeg), "%u.%u", (unsigned)(t / 1000), (unsigned)(t % 1000) / 100);
+    else
+      snprintf(strLeg, sizeof(strLeg), "%4u", (unsigned)(t / 1000) % 1000);
+  }
+  lcdBigLabel(strBuf, strLeg);
+}
+
+/* courseProgressCount is about to move past leg n, ms_tick is the capture time of the base event */
+static void CourseLegDone(uint8_t n, uint32_t ms_tick)
+{
+  if(n < 1 || n > FLIGHT_LEGS)
+    return;
+  flightRecord.split_ms[n - 1] = MsTimer_Duration(&stateTimer, ms_tick);
+  flightRecord.legs = n;
+  flightRecord.sources |= (baseSource << (n - 1));
+}
+
+static const char *itov(uint32_t i);
+
+static void CourseLegCallout()
+{
+#if F3F_LEG_CALLOUT
+  uint32_t s = CourseLegTime(flightRecord.legs) / 1000;
+
+  if(s < 20) {
+    Mp3Player_Play(itov(s));
+  } else if(s < 100) {
+    Mp3Player_Play(itov(s - (s % 10)));
+    if((s % 10) != 0)
+      Mp3Player_Play(itov(s % 10));
+  }
+#endif
+}
+
 static void CourseState_OnEnter(uint32_t ms_tick)
 {
   courseProgressCount = 0;
+  memset(&flightRecord, 0, sizeof(flightRecord));
 
   MsTimer_Reset(&stateTimer);
   MsTimer_SetupInterval(&stateTimer, 10, CourseState_OnInterval);
@@ -455,9 +542,8 @@ static void CourseState_OnEnter(uint32_t ms_tick)
     courseProgressCount++;
   }
 
-  snprintf(strBuf, 16, "Course %d", courseProgressCount);
-  lcdPrintRow(2, strBuf);
-  lcdPrintRow(3, strBlank);
+  CourseLabel();
+  lcdBigTime(0);
 }
 
 static void CourseState_OnLoop()
@@ -478,12 +564,13 @@ static void CourseState_OnKey(uint8_t key, uint32_t ms_tick)
       break;
     case KEY_BASE_A:
       if(thirtySecondOutSide == false) {
-        lcdPrintRow(2, strOutSide);
+        lcdBigLabel("Out", "side");
         Mp3Player_PlayPriority("vocal/outside.mp3");
         thirtySecondOutSide = true;
       } else {
         if(courseProgressCount % 2 == 0) {
           if(courseProgressCount == 10) {
+            CourseLegDone(courseProgressCount, ms_tick);
             Mp3Player_PlayPriority("vocal/rE.mp3");
             MsTimer_Stop(&stateTimer);
             currentState = &finishState;
@@ -491,9 +578,10 @@ static void CourseState_OnKey(uint8_t key, uint32_t ms_tick)
             break;
           } else 
             Mp3Player_PlayPriority("vocal/rA.mp3");
+          CourseLegDone(courseProgressCount, ms_tick);
           courseProgressCount++;
-          snprintf(strBuf, 16, "Course %d", courseProgressCount);
-          lcdPrintRow(2, strBuf);
+          CourseLabel();
+          CourseLegCallout();
         }
       }
       break;
@@ -503,9 +591,10 @@ static void CourseState_OnKey(uint8_t key, uint32_t ms_tick)
           Mp3Player_PlayPriority("vocal/rFinal.mp3");
         else
           Mp3Player_PlayPriority("vocal/rB.mp3");
+        CourseLegDone(courseProgressCount, ms_tick);
         courseProgressCount++;
-        snprintf(strBuf, 16, "Course %d", courseProgressCount);
-        lcdPrintRow(2, strBuf);
+        CourseLabel();
+        CourseLegCallout();
       }
       break;
   }
@@ -517,51 +606,7 @@ static void CourseState_OnTimeout()
 
 static void CourseState_OnInterval(uint32_t time_ms)
 {
-  lcdPrintRow(3, "              %3u.%02u", time_ms / 1000, (time_ms % 1000) / 10);
-}
-
-/**/
-
-static void SaveResult(const char *id, const char *result)
-{
-#if 0    
-  char filePath[128];
-  FRESULT res;
-  DIR dir;
-
-  sprintf(filePath, "f3f");
-  res = f_opendir(&dir, filePath); /* Open the directory */
-  if(res == FR_NO_PATH)
-    f_mkdir("f3f");
-  res = f_opendir(&dir, filePath);
-  if(res != FR_OK) {
-    Usart2_Printf("Fail open %s\r\n", filePath);
-    return;
-  }
-
-  snprintf(filePath, 128, "/f3f/%s.dat", id);
-
-  FIL fp;
-  res = f_open(&fp, filePath, FA_OPEN_ALWAYS | FA_WRITE);
-  if(res != FR_OK) {
-    Usart2_Printf("Fail open %s\r\n", filePath);
-    return;   
-  }
-
-  res = f_lseek(&fp, fp.fsize);
-  if(res != FR_OK) {
-    f_close(&fp);
-    Usart2_Printf("Fail seek %s\r\n", filePath);
-    return;   
-  }
-
-  Usart2_Printf("Open %s successful\r\n", filePath);
-
-  f_puts(result, &fp);
-  f_puts("\n", &fp);
-
-  f_close(&fp);  
-#endif
+  lcdBigTime(time_ms);
 }
 
 static const char *itov(uint32_t i)
@@ -603,8 +648,6 @@ static const char *itov(uint32_t i)
   return "NULL";
 }
 
-const char strFinish[] = "Finish";
-const char strReFlight[] = "Re-flight";
 
 static void FinishState_OnEnter(uint32_t ms_tick)
 {
@@ -612,9 +655,36 @@ static void FinishState_OnEnter(uint32_t ms_tick)
 
   uint32_t cs = (ms_tick % 1000) / 10;
   uint32_t s = ms_tick / 1000;
-  lcdPrintRow(2, strFinish);
-  lcdPrintRow(3, "              %3lu.%02lu", s, cs);
-  snprintf(strLastRecord, 10, "%lu.%02lu", s, cs);
+  lcdBigLabel("Fin", "");
+  lcdBigTime(ms_tick);
+  snprintf(strLastRecord, sizeof(strLastRecord), "%u.%02u", (unsigned)s, (unsigned)cs);
+  lastRecordMs = ms_tick;
+
+  time_t now = time(NULL);
+  flightRecord.uptime_ms = millis();
+  flightRecord.epoch = (now > 1600000000) ? (uint32_t)now : 0;
+  flightRecord.total_ms = ms_tick;
+  flightRecord.mode = F3F_Mode();
+  if(thirtySecondTimeOut)
+    flightRecord.flags |= FLIGHT_FLAG_LATE_ENTRY;
+  if(canBeReFlight)
+    flightRecord.flags |= FLIGHT_FLAG_REFLIGHT;
+  WindStats ws;
+  flightRecord.wind_alerts = Wind_FlightStats(&ws);
+  flightRecord.wind_mean = ws.mean;
+  flightRecord.wind_min = ws.min;
+  flightRecord.wind_max = ws.max;
+  flightRecord.wind_dir = ws.dir;
+  flightRecord.wind_in_sector = ws.inSector;
+  flightRecord.wind_samples = ws.samples;
+  FlightLog_Append(&flightRecord);
+
+  /* a flight marked for a re-flight is not scored, the pilot stays up and the re-flight takes the slot */
+  if(F3F_Mode() == f3fCompetition && Competition_Active() && !canBeReFlight) {
+    Competition_FlightDone(ms_tick);
+    if(s_headLine == showStandings && s_headLineCb)
+      s_headLineCb(s_headLine);
+  }
 
   if(s < 20) {
     Mp3Player_Play(itov(s));
@@ -637,7 +707,7 @@ static void FinishState_OnEnter(uint32_t ms_tick)
   }
 
   if(canBeReFlight) {
-    lcdPrintRow(2, strReFlight);
+    lcdBigLabel("Re-", "fly");
     Mp3Player_Play("vocal/re-flight.mp3");
   }
 }
@@ -679,7 +749,8 @@ static void FinishState_OnInterval(uint32_t time_ms)
 void F3F_Init(void (*headLineCb)(HeadLineType type))
 {
   s_headLineCb = headLineCb;
-  keyPressQueue = xQueueCreate(36, sizeof(uint8_t));
+  keyPressQueue = xQueueCreate(36, sizeof(KeyEvent));
+  Telemetry_Queue("keyPress", keyPressQueue);
 
   MsTimer_Reset(&stateTimer);
 #if 0
@@ -706,14 +777,22 @@ void F3F_Init(void (*headLineCb)(HeadLineType type))
   currentState->OnEnter(millis());
 }
 
+/* Queue a key for the F3F task with the tick it happened at, and trace it */
+static void F3F_PostKey(uint8_t key, uint8_t event, uint16_t serNo)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    KeyEvent r = { key, millis() };
+    bool posted = xQueueSendFromISR(keyPressQueue, &r, &xHigherPriorityTaskWoken) == pdTRUE;
+    Telemetry_QueueSent(keyPressQueue);
+    Trace_Event(event, serNo, posted ? 0 : TRACE_DROPPED);
+}
+
 void F3F_KeyStart()
 {
     static uint32_t latestTick = 0;
 
     if(millis() - latestTick > 200) { /* 200ms debounce */
-        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-        uint8_t r = KEY_START;
-        xQueueSendFromISR(keyPressQueue, &r, &xHigherPriorityTaskWoken);
+        F3F_PostKey(KEY_START, TRACE_START, 0);
     }
     latestTick = millis();
 }
@@ -723,9 +802,7 @@ void F3F_KeyA()
     static uint32_t latestTick = 0;
 
     if(millis() - latestTick > 200) { /* 200ms debounce */
-        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-        uint8_t r = KEY_A;
-        xQueueSendFromISR(keyPressQueue, &r, &xHigherPriorityTaskWoken);
+        F3F_PostKey(KEY_A, TRACE_A, 0);
     }
     latestTick = millis();
 }
@@ -735,9 +812,7 @@ void F3F_KeyB()
     static uint32_t latestTick = 0;
 
     if(millis() - latestTick > 200) { /* 200ms debounce */
-        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-        uint8_t r = KEY_B;
-        xQueueSendFromISR(keyPressQueue, &r, &xHigherPriorityTaskWoken);
+        F3F_PostKey(KEY_B, TRACE_B, 0);
     }
     latestTick = millis();
 }
@@ -747,139 +822,103 @@ void F3F_KeyStop()
     static uint32_t latestTick = 0;
 
     if(millis() - latestTick > 200) { /* 200ms debounce */
-        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-        uint8_t r = KEY_STOP;
-        xQueueSendFromISR(keyPressQueue, &r, &xHigherPriorityTaskWoken);
+        F3F_PostKey(KEY_STOP, TRACE_STOP, 0);
     }
     latestTick = millis();
 }
 
-void F3F_KeyBaseA()
+static void F3F_BaseA(uint8_t source)
 {
     static uint32_t latestTick = 0;
 
     if(millis() - latestTick > 200) { /* 200ms debounce */
-        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-        uint8_t r = KEY_BASE_A;
-        xQueueSendFromISR(keyPressQueue, &r, &xHigherPriorityTaskWoken);
+        if(source == FLIGHT_SRC_REMOTE)
+            F3F_PostKey(KEY_BASE_A | KEY_REMOTE, TRACE_BASE_A | TRACE_REMOTE, serNoA);
+        else
+            F3F_PostKey(KEY_BASE_A, TRACE_BASE_A, 0);
     }
     latestTick = millis();
 }
 
-void F3F_KeyBaseB()
+static void F3F_BaseB(uint8_t source)
 {
     static uint32_t latestTick = 0;
 
     if(millis() - latestTick > 200) { /* 200ms debounce */
-        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-        uint8_t r = KEY_BASE_B;
-        xQueueSendFromISR(keyPressQueue, &r, &xHigherPriorityTaskWoken);
+        if(source == FLIGHT_SRC_REMOTE)
+            F3F_PostKey(KEY_BASE_B | KEY_REMOTE, TRACE_BASE_B | TRACE_REMOTE, serNoB);
+        else
+            F3F_PostKey(KEY_BASE_B, TRACE_BASE_B, 0);
     }
     latestTick = millis();
 }
 
-/*
- * 
- */
-  
-static unsigned char atohex8(unsigned char *s)
+void F3F_KeyBaseA()
 {
-  unsigned char value = 0;
-  if(!s)
-    return 0;
-
-  if(*s >= '0' && *s <= '9')
-    value = (*s - '0') << 4;
-  else if(*s >= 'A' && *s <= 'F')
-    value = ((*s - 'A') + 10) << 4;
-
-  s++;
-
-  if(*s >= '0' && *s <= '9')
-    value |= (*s - '0');
-  else
-    value |= ((*s - 'A') + 10);
-
-  return value;
+    F3F_BaseA(FLIGHT_SRC_WIRED);
 }
 
-union Uint32 {
-  float f;
-  unsigned char u[4];
-};
-
-static float atof32(unsigned char *s)
+void F3F_KeyBaseB()
 {
-  union Uint32 u32;
-
-  u32.u[1] = atohex8(s);
-  s+=2;
-  u32.u[0] = atohex8(s);
-  s+=2;
-  u32.u[3] = atohex8(s);
-  s+=2;
-  u32.u[2] = atohex8(s);
-
-  return u32.f;
+    F3F_BaseB(FLIGHT_SRC_WIRED);
 }
 
-#include <string.h>
+/*
+* Wind that breaks an F3F rule for 20 seconds stops the flight from counting,
+* a flight under way is marked for a re-flight. The samples come in on
+* anemometerTask, a change of the alerts goes to F3F_Task as KEY_WIND so the
+* state and canBeReFlight are only ever looked at and set there.
+*/
+static uint8_t windAlertsShown = 0;   /* F3F_Task */
+static uint8_t windAlertsPosted = 0;  /* anemometerTask */
+static bool windRowStale = false;     /* anemometerTask, row 1 shows an out of range message */
 
-void F3F_AnemometerDecode(unsigned char *data, unsigned int len)
+static void F3F_WindAlerts(uint8_t alerts)
 {
-  unsigned char i;
-  unsigned char *p = (unsigned char *)data;
-  unsigned short direction = 0;
-  float speed = 0;
-
-  for(i=0;i<len;i++) {
-    if(*p == ':') /* Start of MODBUS packet */
-      break;
-    else
-      p++;
-  }
-
-  if(i == len) /* illegal data */
-    return;
+  if((alerts & ~windAlertsShown) && (currentState == &thirtySecondState || currentState == &courseState))
+    canBeReFlight = true;
+  windAlertsShown = alerts;
+
+  if(alerts & WIND_ALERT_LOW)
+    lcdPrintRow(1, "Wind < 3 m/s !!!");
+  else if(alerts & WIND_ALERT_HIGH)
+    lcdPrintRow(1, "Wind > 25 m/s !!!");
+  else if(alerts & WIND_ALERT_DIR)
+    lcdPrintRow(1, "Wind Sector !!!");
+  else
+    lcdPrintRow(1, strBlank);
+}
 
-  if(memcmp(p, ":OOR:1", 6) == 0) { /* Wind speed out of range */
+/* A sample from the anemometer, already added to the wind statistics */
+void F3F_WindSample(uint8_t status)
+{
+  if(status == ANEMOMETER_SPEED_OOR) {
     lcdPrintRow(1, "Wind Speed !!!");
+    windRowStale = true; /* row 1 is redrawn by the next good sample */
     return;
-  } else if(memcmp(p, ":OOR:2", 6) == 0) { /* Wind direction out of range */
+  } else if(status == ANEMOMETER_DIR_OOR) {
     lcdPrintRow(1, "Wind Dir !!!");
+    windRowStale = true;
     return;
-  } else
-    lcdPrintRow(1, strBlank);
+  }
+
+  uint8_t alerts = Wind_Alerts();
+  if(alerts != windAlertsPosted || windRowStale) {
+    KeyEvent e = { KEY_WIND, millis(), alerts };
+    /* with the key queue full the next sample tries again */
+    if(xQueueSend(keyPressQueue, &e, 0) == pdTRUE) {
+      Telemetry_QueueSent(keyPressQueue);
+      windAlertsPosted = alerts;
+      windRowStale = false;
+    }
+  }
 
   if(s_headLine != showWindData)
     return;
 
-  p++; /* Ignore token ':' */
-  i = atohex8(p); /* addr */
-  if(i == 1) { /* addr 1 - Wind speed*/
-    p+=2;
-    i = atohex8(p); /* Func */
-    if(i != 3)
-      return;
-    p+=2;
-    i = atohex8(p); /* Data length */
-    p+=2;
-    i = atohex8(p); /* Wind direction */
-    direction = i << 8;
-    p+=2;
-    i = atohex8(p);
-    direction |= i;
-    p+=2;
-    speed = atof32(p);
-    //Usart2_Printf("%f m/s %s %3d Deg\r\n", speed, (direction < 180) ? "<<" : ">>", direction);
-    //lcdPrintRow(0, "%.2f m/s %s %3d Deg", (double)speed, (direction < 180) ? "<<" : ">>", direction);
-
-    int32_t t = (int32_t)(speed * 100);
-    uint32_t s = t / 100;
-    uint32_t cs = t % 100;
-
-    lcdPrintRow(0, "%d.%d m/s %s %3d Deg", s, cs, (direction < 180) ? "<<" : ">>", direction);
-  }
+  WindStats ws;
+  if(Wind_Stats(&ws))
+    lcdPrintRow(0, "%2u.%u %s%3d %2u/%2u", ws.mean / 100, (ws.mean % 100) / 10, (ws.dir < 180) ? "<<" : ">>", ws.dir, ws.min / 100, (ws.max + 50) / 100);
 }
 
 void F3F_Task(void * pvParameters)
@@ -887,24 +926,29 @@ void F3F_Task(void * pvParameters)
   Mp3Player_Init();
 
   while(1) {
-    uint8_t r;
-    if(xQueueReceive(keyPressQueue, &r, pdMS_TO_TICKS(1))) {
-    //if(xQueueReceive(keyPressQueue, &r, 0)) {
+    KeyEvent e;
+    Cpu_LoopMark(CPU_LOOP_F3F);
+    if(xQueueReceive(keyPressQueue, &e, pdMS_TO_TICKS(1))) {
+    //if(xQueueReceive(keyPressQueue, &e, 0)) {
       F3F_State *s = currentState;
-      switch(r) {
-        case KEY_START: s->OnKey(KEY_START, millis());
+      baseSource = (e.key & KEY_REMOTE) ? FLIGHT_SRC_REMOTE : FLIGHT_SRC_WIRED;
+      switch(e.key & ~KEY_REMOTE) {
+        case KEY_START: s->OnKey(KEY_START, e.tick);
+          break;
+        case KEY_A: s->OnKey(KEY_A, e.tick);
           break;
-        case KEY_A: s->OnKey(KEY_A, millis());
+        case KEY_B: s->OnKey(KEY_B, e.tick);
           break;
-        case KEY_B: s->OnKey(KEY_B, millis());
+        case KEY_STOP: s->OnKey(KEY_STOP, e.tick);
           break;
-        case KEY_STOP: s->OnKey(KEY_STOP, millis());
+        case KEY_BASE_A: s->OnKey(KEY_BASE_A, e.tick);
           break;
-        case KEY_BASE_A: s->OnKey(KEY_BASE_A, millis());
+        case KEY_BASE_B: s->OnKey(KEY_BASE_B, e.tick);
           break;
-        case KEY_BASE_B: s->OnKey(KEY_BASE_B, millis());
+        case KEY_WIND: F3F_WindAlerts(e.alerts);
           break;
       }
+      LATENCY_MARK(LATENCY_STATE);
     }
     currentState->OnLoop();
 
@@ -923,7 +967,7 @@ void F3F_TiggleBaseA(uint32_t serNo)
   currentState->OnLoop();
 */
   serNoA = serNo;
-  F3F_KeyBaseA();
+  F3F_BaseA(FLIGHT_SRC_REMOTE);
 }
 
 void F3F_TiggleBaseB(uint32_t serNo)
@@ -936,7 +980,7 @@ void F3F_TiggleBaseB(uint32_t serNo)
   currentState->OnLoop();
 */
   serNoB = serNo;
-  F3F_KeyBaseB();
+  F3F_BaseB(FLIGHT_SRC_REMOTE);
 }
 
 const char *F3F_LastRecord()
@@ -944,6 +988,29 @@ const char *F3F_LastRecord()
   return strLastRecord;
 }
 
+/* A snapshot for other tasks, every field is read once so it is never torn */
+void F3F_Status(F3fStatus *status)
+{
+  F3F_State *state = currentState;
+  uint32_t start = stateTimer.startTick;
+
+  status->mode = F3F_Mode();
+  status->legs = courseProgressCount;
+  status->last_ms = lastRecordMs;
+  status->time_ms = 0;
+  if(state == &thirtySecondState) {
+    status->state = f3fThirtySecond;
+    status->time_ms = millis() - start;
+  } else if(state == &courseState) {
+    status->state = f3fCourse;
+    status->time_ms = millis() - start;
+  } else if(state == &finishState) {
+    status->state = f3fFinish;
+    status->time_ms = lastRecordMs;
+  } else
+    status->state = f3fIdle;
+}
+
 static F3fMode s_f3fMode = f3fTraining;
 
 F3fMode F3F_Mode()
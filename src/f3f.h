@@ -9,10 +9,11 @@
 #define F3F_H_
 
 typedef enum { f3fCompetition, f3fTraining } F3fMode;
-typedef enum { showCpuUsage, showLastRecord, showF3fMode, showWindData, showVolume, showMaximum } HeadLineType;
+typedef enum { f3fIdle, f3fThirtySecond, f3fCourse, f3fFinish } F3fState;
+typedef enum { showWifi, showCpuUsage, showLastRecord, showF3fMode, showWindData, showVolume, showStandings, showMaximum } HeadLineType;
 
 void F3F_Init(void (*headLineCb)(HeadLineType type));
-void F3F_AnemometerDecode(unsigned char *data, unsigned int len);
+void F3F_WindSample(uint8_t status);
 
 void F3F_TiggleBaseA(uint32_t serNo);
 void F3F_TiggleBaseB(uint32_t serNo);
@@ -28,6 +29,16 @@ void F3F_KeyBaseB();
 void F3F_Task(void * pvParameters);
 const char *F3F_LastRecord();
 
+typedef struct {
+  uint8_t state;      /* F3fState */
+  uint8_t mode;       /* F3fMode */
+  uint8_t legs;       /* legs completed */
+  uint32_t time_ms;   /* running: 30 seconds or course time, final time once finished */
+  uint32_t last_ms;   /* last finished flight, 0 none yet */
+} F3fStatus;
+
+void F3F_Status(F3fStatus *status);
+
 F3fMode F3F_Mode();
 void F3F_Mode(F3fMode mode);
 
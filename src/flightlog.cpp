@@ -0,0 +1,287 @@
+#include <Arduino.h>
+#include <SD.h>
+#include "flightlog.h"
+#include "log.h"
+#include "telemetry.h"
+
+/*
+* Write behind, FlightLog_Append() only queues the record. flightLogTask waits
+* for records at low priority and writes whatever queued up as one batch, a
+* finishing flight never waits on FAT or SPI.
+*
+* Journal, the file is grown in zero filled extents ahead of the records, so an
+* append overwrites slots inside the file and the directory entry only changes
+* once per extent. Record n carries seq n and a CRC. Used slots are never zero
+* and free slots always are, so boot finds the end with a binary search instead
+* of reading the log. A torn or damaged slot fails the check and is skipped.
+*
+* A batch that can not be written, no card or a failed write, is held and
+* tried again every FLIGHT_LOG_RETRY_MS. Records that come in meanwhile wait
+* in the queue, once it is full they are dropped and counted.
+*/
+#define FLIGHT_LOG_QUEUE_SIZE 16
+#define FLIGHT_LOG_BATCH      8
+#define FLIGHT_LOG_EXTENT     512   /* slots, 64 KB */
+#define FLIGHT_LOG_RETRY_MS   2000
+
+static_assert(sizeof(FlightRecord) == 128, "FlightRecord must stay 128 bytes");
+static_assert(512 % sizeof(FlightRecord) == 0, "FlightRecord must not span SD sectors");
+
+static QueueHandle_t flightLogQueue = NULL;
+static SemaphoreHandle_t flightLogMutex = NULL; /* owns flightLogFile */
+static File flightLogFile;
+static uint32_t flightLogSlots = 0;             /* slots in the file */
+static volatile uint32_t flightLogCount = 0;    /* slots used */
+static volatile uint32_t flightLogDropped = 0;
+
+static uint16_t FlightLog_Crc(const uint8_t *p, size_t len)
+{
+	uint16_t crc = 0xffff;
+
+	while(len--) {
+		crc ^= (uint16_t)(*p++) << 8;
+		for(int i = 0; i < 8; i++)
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+	}
+	return crc;
+}
+
+void FlightLog_Seal(FlightRecord *rec, uint32_t seq)
+{
+	rec->seq = seq;
+	rec->magic = FLIGHT_RECORD_MAGIC;
+	rec->crc = FlightLog_Crc((const uint8_t *)rec, offsetof(FlightRecord, crc));
+}
+
+bool FlightLog_Valid(const FlightRecord *rec, uint32_t index)
+{
+	return rec->magic == FLIGHT_RECORD_MAGIC && rec->seq == index &&
+		rec->crc == FlightLog_Crc((const uint8_t *)rec, offsetof(FlightRecord, crc));
+}
+
+static bool FlightLog_Blank(const FlightRecord *rec)
+{
+	const uint8_t *p = (const uint8_t *)rec;
+
+	for(size_t i = 0; i < sizeof(FlightRecord); i++) {
+		if(p[i])
+			return false;
+	}
+	return true;
+}
+
+/*
+* Number of used slots, the first blank slot. A slot that can not be read counts
+* as used so an append never lands on a record. log2(slots) reads.
+*/
+uint32_t FlightLog_Scan(FlightLogReadSlot readSlot, void *ctx, uint32_t slots)
+{
+	uint32_t lo = 0, hi = slots;
+	FlightRecord rec;
+
+	while(lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		if(readSlot(mid, &rec, ctx) && FlightLog_Blank(&rec))
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return lo;
+}
+
+static bool FlightLog_ReadFile(uint32_t index, FlightRecord *rec, void *ctx)
+{
+	File *f = (File *)ctx;
+
+	if(!f->seek(index * sizeof(FlightRecord)))
+		return false;
+	return f->read((uint8_t *)rec, sizeof(FlightRecord)) == sizeof(FlightRecord);
+}
+
+/* Add an extent of blank slots, a torn extent from a power loss is simply grown again */
+static bool FlightLog_Grow()
+{
+	static const uint8_t zero[512] = { 0 };
+	uint32_t len = FLIGHT_LOG_EXTENT * sizeof(FlightRecord);
+
+	if(!flightLogFile.seek(flightLogSlots * sizeof(FlightRecord)))
+		return false;
+	while(len) {
+		size_t n = (len > sizeof(zero)) ? sizeof(zero) : len;
+		if(flightLogFile.write(zero, n) != n)
+			return false;
+		len -= n;
+	}
+	flightLogFile.flush();
+	flightLogSlots += FLIGHT_LOG_EXTENT;
+	return true;
+}
+
+/* The log of an earlier record layout is kept aside, this firmware can not read it */
+static void FlightLog_Rotate()
+{
+	static const char *oldPath = FLIGHT_LOG_OLD_PATH ".old";
+
+	if(!SD.exists(FLIGHT_LOG_OLD_PATH))
+		return;
+	if(SD.exists(oldPath))
+		SD.remove(oldPath);
+	if(SD.rename(FLIGHT_LOG_OLD_PATH, oldPath))
+		LOG_I("Flight log %s moved to %s", FLIGHT_LOG_OLD_PATH, oldPath);
+	else
+		LOG_W("Fail move %s", FLIGHT_LOG_OLD_PATH);
+}
+
+static bool FlightLog_Open()
+{
+	if(flightLogFile)
+		return true;
+
+	if(!SD.exists("/f3f"))
+		SD.mkdir("/f3f");
+	if(!SD.exists(FLIGHT_LOG_PATH)) {
+		FlightLog_Rotate();
+		File f = SD.open(FLIGHT_LOG_PATH, FILE_WRITE);
+		if(f)
+			f.close();
+	}
+	flightLogFile = SD.open(FLIGHT_LOG_PATH, "r+");
+	if(!flightLogFile) {
+		LOG_E("Fail open %s", FLIGHT_LOG_PATH);
+		return false;
+	}
+
+	uint32_t ms = millis();
+	flightLogSlots = flightLogFile.size() / sizeof(FlightRecord);
+	flightLogCount = FlightLog_Scan(FlightLog_ReadFile, &flightLogFile, flightLogSlots);
+
+	FlightRecord rec;
+	if(flightLogCount && !(FlightLog_ReadFile(flightLogCount - 1, &rec, &flightLogFile) && FlightLog_Valid(&rec, flightLogCount - 1)))
+		LOG_W("Flight log slot %u is damaged", (unsigned)(flightLogCount - 1));
+	LOG_I("Flight log %u of %u slots used, scan %u ms", (unsigned)flightLogCount, (unsigned)flightLogSlots, (unsigned)(millis() - ms));
+	return true;
+}
+
+static void FlightLog_Task(void *pvParameters)
+{
+	FlightRecord batch[FLIGHT_LOG_BATCH];
+	uint32_t reported = 0;
+	int n = 0;                  /* records held, kept until they are written */
+	bool failing = false;
+
+	for(;;) {
+		if(n == 0) {
+			if(xQueueReceive(flightLogQueue, &batch[n], portMAX_DELAY) != pdTRUE)
+				continue;
+			n++;
+		}
+		while(n < FLIGHT_LOG_BATCH && xQueueReceive(flightLogQueue, &batch[n], 0) == pdTRUE)
+			n++;
+
+		bool ok = false;
+		xSemaphoreTake(flightLogMutex, portMAX_DELAY);
+		if(FlightLog_Open()) {
+			ok = true;
+			while(ok && flightLogCount + n > flightLogSlots)
+				ok = FlightLog_Grow();
+
+			for(int i = 0; i < n; i++)
+				FlightLog_Seal(&batch[i], flightLogCount + i);
+
+			size_t len = n * sizeof(FlightRecord);
+			if(ok)
+				ok = flightLogFile.seek(flightLogCount * sizeof(FlightRecord)) &&
+					flightLogFile.write((const uint8_t *)batch, len) == len;
+			flightLogFile.flush();
+			if(ok)
+				flightLogCount += n;
+			else
+				flightLogFile.close(); /* the retry reopens and scans again */
+		}
+		xSemaphoreGive(flightLogMutex);
+
+		if(ok) {
+			if(failing)
+				LOG_I("Flight log written again at slot %u", (unsigned)(flightLogCount - n));
+			failing = false;
+			n = 0;
+		} else {
+			if(!failing)
+				LOG_E("Flight log write failed at slot %u, %d records held", (unsigned)flightLogCount, n);
+			failing = true;
+			vTaskDelay(pdMS_TO_TICKS(FLIGHT_LOG_RETRY_MS));
+		}
+
+		if(flightLogDropped != reported) {
+			LOG_W("Flight log %u records dropped", (unsigned)(flightLogDropped - reported));
+			reported = flightLogDropped;
+		}
+	}
+}
+
+void FlightLog_Init()
+{
+	flightLogQueue = xQueueCreate(FLIGHT_LOG_QUEUE_SIZE, sizeof(FlightRecord));
+	Telemetry_Queue("flightLog", flightLogQueue);
+	flightLogMutex = xSemaphoreCreateMutex();
+
+	xSemaphoreTake(flightLogMutex, portMAX_DELAY);
+	FlightLog_Open();
+	xSemaphoreGive(flightLogMutex);
+
+	xTaskCreatePinnedToCore(FlightLog_Task, "FlightLog_Task", 4096, NULL, 1, NULL, 0);
+}
+
+bool FlightLog_Append(const FlightRecord *rec)
+{
+	if(flightLogQueue == NULL || xQueueSend(flightLogQueue, rec, 0) != pdTRUE) {
+		flightLogDropped++;
+		return false;
+	}
+	Telemetry_QueueSent(flightLogQueue);
+	return true;
+}
+
+uint32_t FlightLog_Count()
+{
+	return flightLogCount;
+}
+
+bool FlightLog_Read(uint32_t index, FlightRecord *rec)
+{
+	bool r = false;
+
+	if(flightLogMutex == NULL || index >= flightLogCount)
+		return false;
+
+	xSemaphoreTake(flightLogMutex, portMAX_DELAY);
+	if(FlightLog_Open())
+		r = FlightLog_ReadFile(index, rec, &flightLogFile) && FlightLog_Valid(rec, index);
+	xSemaphoreGive(flightLogMutex);
+
+	return r;
+}
+
+uint32_t FlightLog_ReadBatch(uint32_t index, FlightRecord *rec, uint32_t n, uint32_t *valid)
+{
+	*valid = 0;
+	if(flightLogMutex == NULL || index >= flightLogCount)
+		return 0;
+	if(n > 32)
+		n = 32;
+	if(n > flightLogCount - index)
+		n = flightLogCount - index;
+
+	xSemaphoreTake(flightLogMutex, portMAX_DELAY);
+	size_t len = n * sizeof(FlightRecord);
+	if(!FlightLog_Open() || !flightLogFile.seek(index * sizeof(FlightRecord)) ||
+			flightLogFile.read((uint8_t *)rec, len) != len)
+		n = 0;
+	xSemaphoreGive(flightLogMutex);
+
+	for(uint32_t i = 0; i < n; i++) {
+		if(FlightLog_Valid(&rec[i], index + i))
+			*valid |= 1UL << i;
+	}
+	return n;
+}
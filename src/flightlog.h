@@ -0,0 +1,61 @@
+#ifndef FLIGHTLOG_H
+#define FLIGHTLOG_H
+
+#include <stdint.h>
+
+#define FLIGHT_LOG_PATH     "/f3f/flights2.jnl"
+#define FLIGHT_LOG_OLD_PATH "/f3f/flights.jnl"      /* 64 and 80 byte records, moved to .old */
+#define FLIGHT_LEGS 10
+
+/* Trigger source of a base event */
+#define FLIGHT_SRC_WIRED  0   /* base input or button on the timer */
+#define FLIGHT_SRC_REMOTE 1   /* CRSF receiver or multicast UDP */
+
+/*
+* One flight, fixed size so record n is at n * sizeof(FlightRecord) and an
+* append never has to look at older records. seq, magic and crc are filled
+* in by the log, a slot that fails the check is a torn or damaged write.
+* 128 bytes, a record never spans two SD sectors. A new field takes bytes
+* from reserved, a new size or layout takes a new path and magic.
+*/
+typedef struct __attribute__((packed)) {
+	uint32_t seq;                       /* increments by one per record */
+	uint32_t uptime_ms;                 /* millis() at finish */
+	uint32_t epoch;                     /* time(), 0 when the clock was not set */
+	uint32_t total_ms;
+	uint32_t split_ms[FLIGHT_LEGS];     /* end of each leg from the course start, 0 if not flown */
+	uint8_t magic;                      /* FLIGHT_RECORD_MAGIC */
+	uint8_t mode;                       /* F3fMode */
+	uint8_t legs;                       /* legs completed */
+	uint8_t flags;                      /* FLIGHT_FLAG_xxx */
+	uint16_t sources;                   /* bit n: trigger source of leg n */
+	uint16_t wind_mean;                 /* wind from the launch to the finish, cm/s */
+	uint16_t wind_min;
+	uint16_t wind_max;
+	uint16_t wind_dir;                  /* mean direction, degrees */
+	uint8_t wind_in_sector;             /* % of samples inside the slope sector */
+	uint8_t wind_alerts;                /* WIND_ALERT_xxx raised during the flight */
+	uint16_t wind_samples;
+	uint8_t reserved[52];
+	uint16_t crc;                       /* CRC-16/CCITT of the bytes above */
+} FlightRecord;
+
+#define FLIGHT_RECORD_MAGIC 0xf5
+
+#define FLIGHT_FLAG_LATE_ENTRY (1 << 0) /* course entered after the 30 seconds ran out */
+#define FLIGHT_FLAG_REFLIGHT   (1 << 1)
+
+void FlightLog_Init();
+bool FlightLog_Append(const FlightRecord *rec);
+uint32_t FlightLog_Count();     /* slots used, damaged ones included */
+bool FlightLog_Read(uint32_t index, FlightRecord *rec); /* false for a damaged slot */
+/* Up to 32 slots from index in one read, bit i of *valid is set for a good record, returns the slots read */
+uint32_t FlightLog_ReadBatch(uint32_t index, FlightRecord *rec, uint32_t n, uint32_t *valid);
+
+/* The journal format, for the recovery test in test/test_flightlog */
+typedef bool (*FlightLogReadSlot)(uint32_t index, FlightRecord *rec, void *ctx);
+void FlightLog_Seal(FlightRecord *rec, uint32_t seq);            /* sets seq, magic and crc */
+bool FlightLog_Valid(const FlightRecord *rec, uint32_t index);
+uint32_t FlightLog_Scan(FlightLogReadSlot readSlot, void *ctx, uint32_t slots); /* slots used */
+
+#endif
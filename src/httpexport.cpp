@@ -0,0 +1,148 @@
+#include <Arduino.h>
+#include <WebServer.h>
+#include "httpexport.h"
+#include "flightlog.h"
+#include "f3f.h"
+#include "log.h"
+
+/*
+* The export never holds more than one chunk of text and one batch of records,
+* under 3 KB, whatever the size of the log. Slots are read a batch at a time
+* under the log mutex and formatted into the chunk, damaged slots are skipped.
+* Only the slots used when the export began are sent, flights finishing during
+* a download are left for the next one.
+*/
+#define HTTP_EXPORT_CHUNK    2048
+#define HTTP_EXPORT_LINE_MAX 384    /* longest formatted record */
+
+enum { stageHeader, stageRecords, stageFooter, stageDone };
+
+static const char *HttpExport_Mode(uint8_t mode)
+{
+	return (mode == f3fCompetition) ? "competition" : "training";
+}
+
+static int HttpExport_Csv(char *p, size_t size, const FlightRecord *r)
+{
+	int n = snprintf(p, size, "%u,%u,%u,%s,%u,%u,%u", (unsigned)r->seq, (unsigned)r->epoch, (unsigned)r->uptime_ms,
+		HttpExport_Mode(r->mode), (unsigned)r->total_ms, r->legs, r->flags);
+	for(int i = 0; i < FLIGHT_LEGS; i++)
+		n += snprintf(p + n, size - n, ",%u", (unsigned)r->split_ms[i]);
+	n += snprintf(p + n, size - n, ",%u,%u,%u,%u,%u,%u,%u\r\n", r->wind_mean, r->wind_min, r->wind_max, r->wind_dir,
+		r->wind_in_sector, r->wind_alerts, r->wind_samples);
+	return n;
+}
+
+static int HttpExport_Json(char *p, size_t size, const FlightRecord *r, bool first)
+{
+	int n = snprintf(p, size, "%s\n{\"seq\":%u,\"epoch\":%u,\"uptime_ms\":%u,\"mode\":\"%s\",\"total_ms\":%u,\"legs\":%u,\"flags\":%u,\"split_ms\":[",
+		first ? "" : ",", (unsigned)r->seq, (unsigned)r->epoch, (unsigned)r->uptime_ms, HttpExport_Mode(r->mode),
+		(unsigned)r->total_ms, r->legs, r->flags);
+	for(int i = 0; i < FLIGHT_LEGS; i++)
+		n += snprintf(p + n, size - n, i ? ",%u" : "%u", (unsigned)r->split_ms[i]);
+	n += snprintf(p + n, size - n, "],\"wind\":{\"mean\":%u,\"min\":%u,\"max\":%u,\"dir\":%u,\"in_sector\":%u,\"alerts\":%u,\"samples\":%u}}",
+		r->wind_mean, r->wind_min, r->wind_max, r->wind_dir, r->wind_in_sector, r->wind_alerts, r->wind_samples);
+	return n;
+}
+
+void HttpExport_Begin(ExportCursor *c, ExportFormat format, uint32_t from)
+{
+	c->format = format;
+	c->index = from;
+	c->end = FlightLog_Count();
+	c->records = 0;
+	c->stage = stageHeader;
+	c->batchLen = c->batchPos = 0;
+}
+
+size_t HttpExport_Chunk(ExportCursor *c, char *buf, size_t size)
+{
+	size_t len = 0;
+
+	if(c->stage == stageHeader) {
+		if(c->format == exportCsv) {
+			len += snprintf(buf, size, "seq,epoch,uptime_ms,mode,total_ms,legs,flags");
+			for(int i = 0; i < FLIGHT_LEGS; i++)
+				len += snprintf(buf + len, size - len, ",split%u_ms", i + 1);
+			len += snprintf(buf + len, size - len, ",wind_mean,wind_min,wind_max,wind_dir,wind_in_sector,wind_alerts,wind_samples\r\n");
+		} else
+			len += snprintf(buf, size, "[");
+		c->stage = stageRecords;
+	}
+
+	while(c->stage == stageRecords && size - len > HTTP_EXPORT_LINE_MAX) {
+		if(c->batchPos == c->batchLen) {
+			uint32_t n = (c->index < c->end) ?
+				FlightLog_ReadBatch(c->index, c->batch, min((uint32_t)HTTP_EXPORT_BATCH, c->end - c->index), &c->valid) : 0;
+			if(n == 0) { /* end of the log, or it can not be read */
+				c->stage = stageFooter;
+				break;
+			}
+			c->index += n;
+			c->batchLen = n;
+			c->batchPos = 0;
+		}
+
+		uint8_t i = c->batchPos++;
+		if(!(c->valid & (1UL << i)))
+			continue;
+		if(c->format == exportCsv)
+			len += HttpExport_Csv(buf + len, size - len, &c->batch[i]);
+		else
+			len += HttpExport_Json(buf + len, size - len, &c->batch[i], c->records == 0);
+		c->records++;
+	}
+
+	if(c->stage == stageFooter) {
+		if(c->format == exportJson)
+			len += snprintf(buf + len, size - len, "\n]\n");
+		c->stage = stageDone;
+	}
+
+	return len;
+}
+
+static WebServer httpServer(HTTP_EXPORT_PORT);
+
+static void HttpExport_Send(ExportFormat format)
+{
+	static char chunk[HTTP_EXPORT_CHUNK]; /* one request at a time, the server task owns it */
+	ExportCursor c;
+	uint32_t ms = millis();
+
+	HttpExport_Begin(&c, format, httpServer.hasArg("from") ? httpServer.arg("from").toInt() : 0);
+
+	httpServer.setContentLength(CONTENT_LENGTH_UNKNOWN); /* chunked */
+	httpServer.sendHeader("Content-Disposition", (format == exportCsv) ? "attachment; filename=flights.csv" : "attachment; filename=flights.json");
+	httpServer.send(200, (format == exportCsv) ? "text/csv" : "application/json", "");
+
+	size_t n;
+	while((n = HttpExport_Chunk(&c, chunk, sizeof(chunk))) > 0) {
+		httpServer.sendContent(chunk, n);
+		if(!httpServer.client().connected())
+			break;
+	}
+	httpServer.sendContent("");
+
+	LOG_I("Exported %u flights in %u ms", (unsigned)c.records, (unsigned)(millis() - ms));
+}
+
+static void HttpExport_Task(void *pvParameters)
+{
+	httpServer.on("/flights.csv", HTTP_GET, []() { HttpExport_Send(exportCsv); });
+	httpServer.on("/flights.json", HTTP_GET, []() { HttpExport_Send(exportJson); });
+	httpServer.on("/", HTTP_GET, []() {
+		httpServer.send(200, "text/html", "<a href=\"/flights.csv\">flights.csv</a><br><a href=\"/flights.json\">flights.json</a>");
+	});
+	httpServer.begin();
+
+	for(;;) {
+		httpServer.handleClient();
+		vTaskDelay(pdMS_TO_TICKS(5));
+	}
+}
+
+void HttpExport_Init()
+{
+	xTaskCreatePinnedToCore(HttpExport_Task, "HttpExport_Task", 6144, NULL, 1, NULL, 0);
+}
@@ -0,0 +1,34 @@
+#ifndef HTTPEXPORT_H
+#define HTTPEXPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "flightlog.h"
+
+#define HTTP_EXPORT_PORT  80
+#define HTTP_EXPORT_BATCH 8       /* records per read of the log */
+
+typedef enum { exportCsv, exportJson } ExportFormat;
+
+/* Position in an export, the text is made a chunk at a time from the log */
+typedef struct {
+	ExportFormat format;
+	uint32_t index;         /* next slot */
+	uint32_t end;           /* slots used when the export began */
+	uint32_t records;       /* records written so far */
+	uint8_t stage;
+	uint8_t batchLen, batchPos;
+	uint32_t valid;
+	FlightRecord batch[HTTP_EXPORT_BATCH];
+} ExportCursor;
+
+void HttpExport_Begin(ExportCursor *c, ExportFormat format, uint32_t from);
+size_t HttpExport_Chunk(ExportCursor *c, char *buf, size_t size); /* 0 when done */
+
+/*
+* GET /flights.csv and /flights.json, ?from=n starts at slot n. Served by a low
+* priority task on core 0, chunked transfer straight from the log on SD.
+*/
+void HttpExport_Init();
+
+#endif
@@ -0,0 +1,151 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "latency.h"
+#include "f3f.h"
+
+#ifdef LATENCY_BENCHMARK
+
+/*
+* A flight is start, 12 base events (outside, entry and 10 legs) and stop, one
+* every LATENCY_PERIOD_MS. Only the base events are samples, every one of them
+* changes the state, plays a priority prompt and changes the big label. The
+* flights end up in the flight log like any other, in training mode.
+*
+* A sample is open until the next event, a stage stamps it once and only after
+* the stage it follows, so the chunks of the file that is still playing or a tick
+* of the clock can not stand in for the effect of the event.
+*/
+#define LATENCY_SAMPLES   240   /* 20 flights */
+#define LATENCY_BASES     12
+#define LATENCY_PERIOD_MS 1500
+#define LATENCY_PULSE_MS  20
+#define LATENCY_MISSED    0xffffffff
+#define LATENCY_NONE      0xff
+
+static const char *const stageNames[LATENCY_STAGES] = { "state", "play", "open", "i2s", "lcd" };
+static const uint8_t stageAfter[LATENCY_STAGES] = { LATENCY_NONE, LATENCY_NONE, LATENCY_PLAY, LATENCY_OPEN, LATENCY_NONE };
+
+static uint32_t latency[LATENCY_STAGES][LATENCY_SAMPLES];
+static uint32_t sampleCount = 0;
+static int64_t sampleStart = 0;
+static uint8_t sampleMarked = 0;
+static volatile bool sampleOpen = false;
+static volatile bool latencyDone = false;
+static portMUX_TYPE latencyMux = portMUX_INITIALIZER_UNLOCKED;
+
+void Latency_Mark(uint8_t stage)
+{
+	if(!sampleOpen || stage >= LATENCY_STAGES)
+		return;
+
+	int64_t t = esp_timer_get_time();
+	portENTER_CRITICAL(&latencyMux);
+	if(sampleOpen && !(sampleMarked & (1 << stage)) &&
+		(stageAfter[stage] == LATENCY_NONE || (sampleMarked & (1 << stageAfter[stage])))) {
+		latency[stage][sampleCount] = (uint32_t)(t - sampleStart);
+		sampleMarked |= 1 << stage;
+	}
+	portEXIT_CRITICAL(&latencyMux);
+}
+
+static void Latency_Open()
+{
+	for(uint8_t i = 0; i < LATENCY_STAGES; i++)
+		latency[i][sampleCount] = LATENCY_MISSED;
+	portENTER_CRITICAL(&latencyMux);
+	sampleMarked = 0;
+	sampleStart = esp_timer_get_time();
+	sampleOpen = true;
+	portEXIT_CRITICAL(&latencyMux);
+}
+
+static void Latency_Close()
+{
+	portENTER_CRITICAL(&latencyMux);
+	sampleOpen = false;
+	portEXIT_CRITICAL(&latencyMux);
+	sampleCount++;
+}
+
+static void Latency_Base(bool a)
+{
+	Latency_Open();
+#if defined(LATENCY_PIN_A) && defined(LATENCY_PIN_B)
+	uint8_t pin = a ? LATENCY_PIN_A : LATENCY_PIN_B;
+	digitalWrite(pin, LOW);
+	vTaskDelay(pdMS_TO_TICKS(LATENCY_PULSE_MS));
+	digitalWrite(pin, HIGH);
+	vTaskDelay(pdMS_TO_TICKS(LATENCY_PERIOD_MS - LATENCY_PULSE_MS));
+#else
+	if(a)
+		F3F_KeyBaseA();
+	else
+		F3F_KeyBaseB();
+	vTaskDelay(pdMS_TO_TICKS(LATENCY_PERIOD_MS));
+#endif
+	Latency_Close();
+}
+
+static int Latency_Compare(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+/* Nearest rank percentiles of what was stamped, one JSON object per stage */
+static void Latency_Report()
+{
+	Serial.printf("[\r\n");
+	for(uint8_t i = 0; i < LATENCY_STAGES; i++) {
+		uint32_t *v = latency[i];
+		qsort(v, sampleCount, sizeof(uint32_t), Latency_Compare);
+		uint32_t n = 0;
+		while(n < sampleCount && v[n] != LATENCY_MISSED)
+			n++;
+
+		Serial.printf("%s{\"stage\":\"%s\",\"samples\":%u,\"missed\":%u", i ? "," : "", stageNames[i],
+			(unsigned)n, (unsigned)(sampleCount - n));
+		if(n)
+			Serial.printf(",\"min_us\":%u,\"median_us\":%u,\"p99_us\":%u,\"max_us\":%u", (unsigned)v[0],
+				(unsigned)v[(n + 1) / 2 - 1], (unsigned)v[(n * 99 + 99) / 100 - 1], (unsigned)v[n - 1]);
+		Serial.printf("}\r\n");
+	}
+	Serial.printf("]\r\n");
+}
+
+static void latencyTask(void *pvParameters)
+{
+	vTaskDelay(pdMS_TO_TICKS(5000)); /* the timer is up and idle */
+	F3F_Mode(f3fTraining);
+
+	while(sampleCount + LATENCY_BASES <= LATENCY_SAMPLES) {
+		F3F_KeyStart();
+		vTaskDelay(pdMS_TO_TICKS(LATENCY_PERIOD_MS));
+		for(uint8_t i = 0; i < LATENCY_BASES; i++)
+			Latency_Base(i < 2 || (i % 2) == 1); /* A outside, A entry, then B, A, ..., A */
+		F3F_KeyStop();
+		vTaskDelay(pdMS_TO_TICKS(LATENCY_PERIOD_MS));
+	}
+
+	Latency_Report();
+	latencyDone = true;
+	vTaskDelete(NULL);
+}
+
+void Latency_Init()
+{
+#if defined(LATENCY_PIN_A) && defined(LATENCY_PIN_B)
+	pinMode(LATENCY_PIN_A, OUTPUT);
+	digitalWrite(LATENCY_PIN_A, HIGH);
+	pinMode(LATENCY_PIN_B, OUTPUT);
+	digitalWrite(LATENCY_PIN_B, HIGH);
+#endif
+	xTaskCreatePinnedToCore(latencyTask, "latencyTask", 3072, NULL, 1, NULL, 0);
+}
+
+bool Latency_Done()
+{
+	return latencyDone;
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+
+/*
+* End to end latency of a base event, built with -D LATENCY_BENCHMARK. A task
+* injects base events on a schedule and every stage stamps the first time it
+* sees the effect of one, in microseconds from the injection. The distribution
+* of every stage goes to the serial port as JSON after LATENCY_SAMPLES events.
+*
+* The events go through F3F_KeyBaseA/B() unless LATENCY_PIN_A and LATENCY_PIN_B
+* are defined, then the task pulls these outputs low and they have to be wired
+* to the BASE_A and BASE_B inputs, the polling in loop() is measured as well.
+*/
+
+/* stage */
+#define LATENCY_STATE  0    /* the F3F task ran the key through the state machine */
+#define LATENCY_PLAY   1    /* Mp3Player_PlayPriority() */
+#define LATENCY_OPEN   2    /* the player opened the file */
+#define LATENCY_I2S    3    /* the first chunk of it went to I2S */
+#define LATENCY_LCD    4    /* the display task sent the new label */
+#define LATENCY_STAGES 5
+
+#ifdef LATENCY_BENCHMARK
+void Latency_Init();
+void Latency_Mark(uint8_t stage);   /* any task, never blocks */
+bool Latency_Done();
+#define LATENCY_MARK(stage) Latency_Mark(stage)
+#else
+#define LATENCY_MARK(stage) do {} while(0)
+#endif
+
+#endif
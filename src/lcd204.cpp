@@ -1,5 +1,8 @@
 #include <Arduino.h>
 #include "lcd204.h"
+#include "log.h"
+#include "latency.h"
+#include "telemetry.h"
 
 #include <Wire.h>
 #include <hd44780.h>                       // main hd44780 header
@@ -10,12 +13,175 @@ hd44780_I2Cexp lcd; // declare lcd object: auto locate & auto config expander ch
 const int LCD_COLS = 20;
 const int LCD_ROWS = 4;
 
+/*
+* Display service. lcdTask is the only task that touches lcd, everybody else posts a
+* LcdMsg and returns without waiting. The task applies the messages to its framebuffer
+* and then sends the cells that changed.
+*/
+#define LCD_REFRESH_MS 40   /* at most 25 flushes per second, later messages coalesce */
+#define LCD_GAP_MAX 1       /* rewriting one unchanged cell costs the same as a setCursor() */
+#define LCD_QUEUE_SIZE 32
+
+typedef enum { lcdMsgCells, lcdMsgClear, lcdMsgNoCursor, lcdMsgBigTime } LcdMsgType;
+
+typedef struct {
+    uint8_t type;
+    uint8_t row;
+    uint8_t col;
+    uint8_t len;
+    union {
+        char text[LINE_SIZE];
+        uint32_t time_ms;
+    };
+} LcdMsg;
+
+static QueueHandle_t lcdQueue = NULL;
+static volatile uint32_t lcdDropped = 0;
+
+static char frameBuf[LCD_ROWS][LCD_COLS];   /* wanted content, lcdTask only */
+static char lcdBuf[LCD_ROWS][LCD_COLS];     /* content on the display, lcdTask only */
+
+/*
+* Big numerals, 3 x 2 cells per digit built from 8 custom characters. The time is
+* rendered into the framebuffer and lcdFlush() only sends the cells of the digits
+* that changed, a centisecond tick costs a few characters on the bus.
+*/
+#define BIG_FULL 0xff       /* built in full block */
+#define BIG_BLANK 0x20
+
+static const uint8_t bigGlyphs[8][8] PROGMEM = {
+    { 0x07, 0x0f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f }, /* 0 left top */
+    { 0x1f, 0x1f, 0x1f, 0x00, 0x00, 0x00, 0x00, 0x00 }, /* 1 upper bar */
+    { 0x1c, 0x1e, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f }, /* 2 right top */
+    { 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x0f, 0x07 }, /* 3 left low */
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x1f, 0x1f }, /* 4 lower bar */
+    { 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1e, 0x1c }, /* 5 right low */
+    { 0x1f, 0x1f, 0x1f, 0x00, 0x00, 0x00, 0x1f, 0x1f }, /* 6 upper and middle bar */
+    { 0x1f, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x1f, 0x1f }, /* 7 lower and middle bar */
+};
+
+static const uint8_t bigDigits[10][2][3] = {
+    { {   0,   1,   2 }, {   3,   4,   5 } },
+    { {   1,   2, BIG_BLANK }, {   4, BIG_FULL,   4 } },
+    { {   6,   6,   2 }, {   3,   4,   4 } },
+    { {   6,   6,   2 }, {   4,   4,   5 } },
+    { {   3,   4, BIG_FULL }, { BIG_BLANK, BIG_BLANK, BIG_FULL } },
+    { { BIG_FULL,   6,   6 }, {   4,   4,   5 } },
+    { {   0,   6,   6 }, {   3,   4,   5 } },
+    { {   1,   1,   2 }, { BIG_BLANK, BIG_BLANK, BIG_FULL } },
+    { {   0,   6,   2 }, {   3,   4,   5 } },
+    { {   0,   6,   2 }, { BIG_BLANK, BIG_BLANK, BIG_FULL } },
+};
+
+#define BIG_ROW 2           /* rows 2 and 3 */
+#define BIG_COL (LCD_COLS - 16)   /* "SSS.CC" is 16 cells wide, the columns on the left are the label */
+
+static void bigDigit(int col, int d)
+{
+    if(d < 0) {
+        memset(&frameBuf[BIG_ROW][col], BIG_BLANK, 3);
+        memset(&frameBuf[BIG_ROW + 1][col], BIG_BLANK, 3);
+    } else {
+        memcpy(&frameBuf[BIG_ROW][col], bigDigits[d][0], 3);
+        memcpy(&frameBuf[BIG_ROW + 1][col], bigDigits[d][1], 3);
+    }
+}
+
+static void bigTime(uint32_t time_ms)
+{
+    uint32_t s = (time_ms / 1000) % 1000;
+    uint32_t cs = (time_ms % 1000) / 10;
+    int col = BIG_COL;
+
+    bigDigit(col, (s >= 100) ? (int)(s / 100) : -1);
+    bigDigit(col + 3, (s >= 10) ? (int)(s / 10 % 10) : -1);
+    bigDigit(col + 6, s % 10);
+    frameBuf[BIG_ROW][col + 9] = BIG_BLANK;
+    frameBuf[BIG_ROW + 1][col + 9] = 4; /* decimal point */
+    bigDigit(col + 10, cs / 10);
+    bigDigit(col + 13, cs % 10);
+}
+
+static void lcdPost(const LcdMsg *m)
+{
+    if(lcdQueue == NULL || xQueueSend(lcdQueue, m, 0) != pdTRUE)
+        lcdDropped++; /* never wait on the display, the next update of the row repairs it */
+    else
+        Telemetry_QueueSent(lcdQueue);
+}
+
+static void lcdApply(const LcdMsg *m)
+{
+    switch(m->type) {
+        case lcdMsgCells:
+            if(m->row < LCD_ROWS && m->col < LCD_COLS)
+                memcpy(&frameBuf[m->row][m->col], m->text, min((int)m->len, LCD_COLS - m->col));
+            break;
+        case lcdMsgClear:
+            memset(frameBuf, 0x20, sizeof(frameBuf));
+            break;
+        case lcdMsgNoCursor:
+            lcd.noCursor();
+            break;
+        case lcdMsgBigTime:
+            bigTime(m->time_ms);
+            break;
+    }
+}
+
+static void lcdFlush()
+{
+    for(int row = 0; row < LCD_ROWS; row++) {
+        int col = 0;
+        while(col < LCD_COLS) {
+            if(frameBuf[row][col] == lcdBuf[row][col]) {
+                col++;
+                continue;
+            }
+            int end = col + 1; /* extend the run over short gaps of unchanged cells */
+            for(int i = end; i < LCD_COLS && i <= end + LCD_GAP_MAX; i++) {
+                if(frameBuf[row][i] != lcdBuf[row][i])
+                    end = i + 1;
+            }
+            lcd.setCursor(col, row);
+            lcd.write((const uint8_t *)&frameBuf[row][col], end - col);
+            memcpy(&lcdBuf[row][col], &frameBuf[row][col], end - col);
+            col = end;
+        }
+    }
+}
+
+static void lcdTask(void *pvParameters)
+{
+    LcdMsg m;
+    uint32_t reported = 0;
+
+    for(;;) {
+        bool label = false; /* the big label changed, the F3F state did */
+        xQueueReceive(lcdQueue, &m, portMAX_DELAY);
+        do {
+            lcdApply(&m);
+            label |= (m.type == lcdMsgCells && m.row >= BIG_ROW && m.col < BIG_COL);
+        } while(xQueueReceive(lcdQueue, &m, 0) == pdTRUE);
+
+        lcdFlush();
+        if(label)
+            LATENCY_MARK(LATENCY_LCD);
+
+        if(lcdDropped != reported) {
+            LOG_W("lcd %u messages dropped", (unsigned)(lcdDropped - reported));
+            reported = lcdDropped;
+        }
+        vTaskDelay(pdMS_TO_TICKS(LCD_REFRESH_MS));
+    }
+}
+
 void lcd2004Setup()
 {
     int status;
 
-    //Wire.setClock(400000);      // Set the I2C SCL to 400kHz
     Wire.begin(I2C_SDA, I2C_SCL);
+    Wire.setClock(400000);      // Set the I2C SCL to 400kHz, the expander bursts depend on it
 
     lcd.setExecTimes(2000, 600);
     status = lcd.begin(LCD_COLS, LCD_ROWS);
@@ -23,9 +189,28 @@ void lcd2004Setup()
         Serial.println("LCD 2004A Init Failed !!!");
         hd44780::fatalError(status); // never return ...
     }
-    lcd.setCursor(0,0);
+    /*
+     * 2000/600 us are worst case for slow modules, measure this one when r/w is wired.
+     * Only at boot, the 25% margin covers the drift of the module clock while the timer runs.
+     */
+    status = lcd.calibrateExecTimes();
+    uint32_t chUs, insUs;
+    lcd.getExecTimes(chUs, insUs);
+    if(status)
+        LOG_W("LCD calibration failed (%d), exec times %u/%u us", status, (unsigned)chUs, (unsigned)insUs);
+    else
+        LOG_I("LCD exec times %u/%u us", (unsigned)chUs, (unsigned)insUs);
+    for(uint8_t i = 0; i < 8; i++)
+        lcd.createChar(i, bigGlyphs[i]);
+    memset(frameBuf, 0x20, sizeof(frameBuf));
+    memset(lcdBuf, 0x20, sizeof(lcdBuf)); /* begin() cleared the display */
+
+    lcdQueue = xQueueCreate(LCD_QUEUE_SIZE, sizeof(LcdMsg));
+    Telemetry_Queue("lcd", lcdQueue);
+    xTaskCreatePinnedToCore(lcdTask, "lcdTask", 4096, NULL, 1, NULL, 0);
+
     // Print a message to the LCD
-    lcd.printf("  *** F3F Timer ***  ");	
+    lcdPrintRow(0, "  *** F3F Timer ***");
 }
 
 void lcd2004Loop()
@@ -49,12 +234,8 @@ void lcd2004Loop()
 	}
 }
 
-SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
-
 void lcdPrintRow(uint8_t row, const char *fmt, ...)
 {
-    xSemaphoreTake(mutex, portMAX_DELAY); // enter critical section
-
     char str[LINE_SIZE+1];
     va_list args;
   
@@ -62,29 +243,62 @@ void lcdPrintRow(uint8_t row, const char *fmt, ...)
     int r = vsnprintf(str, LINE_SIZE+1, fmt, args);
     va_end(args);
 
-    Serial.printf("%s\t(%d)\r\n", str, r);
+    LOG_D("%s\t(%d)", str, r);
 
     if(r >= 0) {
         if(r < LINE_SIZE)
             memset(str+r, 0x20, LINE_SIZE-r);
-        str[LINE_SIZE] = '\0';
-        lcd.setCursor(0, row);
-        lcd.printf(str);            
+        lcdSetCells(row, 0, str, LINE_SIZE);
     }
-
-    xSemaphoreGive(mutex); // exit critical section
 }
 
-// Must manually destroy the mutex when no longer needed:
-//vSemaphoreDelete(mutex);
+void lcdSetCells(uint8_t row, uint8_t col, const char *text, uint8_t len)
+{
+    LcdMsg m;
+
+    if(row >= LCD_ROWS || col >= LCD_COLS)
+        return;
+    m.type = lcdMsgCells;
+    m.row = row;
+    m.col = col;
+    m.len = min((int)len, LCD_COLS - col);
+    memcpy(m.text, text, m.len);
+    lcdPost(&m);
+}
 
 void lcdNoCursor()
 {
-    lcd.noCursor();
+    LcdMsg m;
+
+    m.type = lcdMsgNoCursor;
+    lcdPost(&m);
 }
 
 void lcdClear()
 {
-    lcd.clear();
+    LcdMsg m;
+
+    m.type = lcdMsgClear;
+    lcdPost(&m);
 }
 
+void lcdBigTime(uint32_t time_ms)
+{
+    LcdMsg m;
+
+    m.type = lcdMsgBigTime;
+    m.time_ms = time_ms;
+    lcdPost(&m);
+}
+
+void lcdBigLabel(const char *top, const char *bottom)
+{
+    char str[BIG_COL];
+
+    memset(str, 0x20, sizeof(str));
+    memcpy(str, top, min(strlen(top), sizeof(str)));
+    lcdSetCells(BIG_ROW, 0, str, sizeof(str));
+    memset(str, 0x20, sizeof(str));
+    memcpy(str, bottom, min(strlen(bottom), sizeof(str)));
+    lcdSetCells(BIG_ROW + 1, 0, str, sizeof(str));
+}
@@ -11,7 +11,12 @@
 void lcd2004Setup();
 void lcd2004Loop();
 
+/* Non blocking, the text is posted to the display task */
 void lcdPrintRow(uint8_t row, const char *fmt, ...);
+void lcdSetCells(uint8_t row, uint8_t col, const char *text, uint8_t len);
+/* Flight time in big numerals on rows 2 and 3, a 4 x 2 label fits on their left */
+void lcdBigTime(uint32_t time_ms);
+void lcdBigLabel(const char *top, const char *bottom);
 void lcdNoCursor();
 void lcdClear();
 
@@ -0,0 +1,84 @@
+#include <Arduino.h>
+#include <atomic>
+#include "log.h"
+
+#define LOG_SLOTS     32    /* power of two */
+#define LOG_SLOT_SIZE 96    /* longer messages are truncated */
+#define LOG_DRAIN_MS  20
+
+typedef struct {
+    std::atomic<bool> ready;
+    uint8_t len;
+    char text[LOG_SLOT_SIZE];
+} LogSlot;
+
+static LogSlot slots[LOG_SLOTS];
+static std::atomic<uint32_t> head(0);    /* next slot to claim, producers */
+static std::atomic<uint32_t> tail(0);    /* next slot to print, drain task */
+static std::atomic<uint32_t> dropped(0);
+
+static const char levelChar[] = { ' ', 'E', 'W', 'I', 'D' };
+
+/*
+* Claim a slot with a CAS on head, format into it and publish it with the ready flag.
+* Safe from any task, the slot is private to the producer between the claim and the publish.
+*/
+void Log_Printf(uint8_t level, const char *fmt, ...)
+{
+    uint32_t h = head.load(std::memory_order_relaxed);
+    do {
+        if(h - tail.load(std::memory_order_acquire) >= LOG_SLOTS) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    } while(!head.compare_exchange_weak(h, h + 1, std::memory_order_acquire, std::memory_order_relaxed));
+
+    LogSlot *s = &slots[h & (LOG_SLOTS - 1)];
+    int n = snprintf(s->text, LOG_SLOT_SIZE, "%lu %c ", (unsigned long)millis(), levelChar[level <= LOG_LEVEL_DEBUG ? level : 0]);
+
+    va_list args;
+    va_start(args, fmt);
+    int m = vsnprintf(s->text + n, LOG_SLOT_SIZE - n, fmt, args);
+    va_end(args);
+
+    n += (m < 0) ? 0 : m;
+    if(n > LOG_SLOT_SIZE - 1)
+        n = LOG_SLOT_SIZE - 1;
+    s->len = n;
+    s->ready.store(true, std::memory_order_release);
+}
+
+uint32_t Log_Dropped()
+{
+    return dropped.load(std::memory_order_relaxed);
+}
+
+static void logDrainTask(void *pvParameters)
+{
+    uint32_t reported = 0;
+
+    for(;;) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        LogSlot *s = &slots[t & (LOG_SLOTS - 1)];
+        while(s->ready.load(std::memory_order_acquire)) {
+            Serial.write((const uint8_t *)s->text, s->len);
+            Serial.write("\r\n");
+            s->ready.store(false, std::memory_order_relaxed);
+            tail.store(++t, std::memory_order_release); /* hand the slot back to the producers */
+            s = &slots[t & (LOG_SLOTS - 1)];
+        }
+
+        uint32_t d = Log_Dropped();
+        if(d != reported) {
+            Serial.printf("%lu W %u log messages dropped\r\n", (unsigned long)millis(), (unsigned)(d - reported));
+            reported = d;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_MS));
+    }
+}
+
+void Log_Init()
+{
+    xTaskCreatePinnedToCore(logDrainTask, "logDrainTask", 3072, NULL, 1, NULL, 0);
+}
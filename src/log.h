@@ -0,0 +1,55 @@
+/*
+ * log.h
+ *
+ * Asynchronous serial log. Producers format into a fixed ring of slots and return, a low
+ * priority task drains the ring to Serial. When the ring is full the message is dropped and
+ * counted, a producer never waits for the UART.
+ *
+ * Messages below LOG_LEVEL are compiled out, e.g. in platformio.ini:
+ *
+ *     build_flags = -D LOG_LEVEL=LOG_LEVEL_DEBUG
+ */
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+void Log_Init();
+void Log_Printf(uint8_t level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+uint32_t Log_Dropped();
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(fmt, ...) Log_Printf(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define LOG_E(fmt, ...) do {} while(0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(fmt, ...) Log_Printf(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#else
+#define LOG_W(fmt, ...) do {} while(0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(fmt, ...) Log_Printf(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define LOG_I(fmt, ...) do {} while(0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(fmt, ...) Log_Printf(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define LOG_D(fmt, ...) do {} while(0)
+#endif
+
+#endif
@@ -5,6 +5,17 @@
 #include "player.h"
 #include "lcd204.h"
 #include "f3f.h"
+#include "log.h"
+#include "flightlog.h"
+#include "competition.h"
+#include "anemometer.h"
+#include "httpexport.h"
+#include "status.h"
+#include "trace.h"
+#include "latency.h"
+#include "remote.h"
+#include "cpu.h"
+#include "telemetry.h"
 
 #define BUZZER 21
 
@@ -132,14 +143,14 @@ crsfB.update();
     if (timeNow - lastPrint >= 300)
     {
       if(crsfA.rcToUs(crsfA.getChannel(1)) == 2000) {
-        Serial.printf("<A%04u>\r\n", serNoA % 10000);
+        LOG_I("<A%04u>", serNoA % 10000);
         F3F_TiggleBaseA(serNoA++);
         yield();
         buzzerStart();
       }
 
       if(crsfB.rcToUs(crsfB.getChannel(1)) == 2000) {
-        Serial.printf("<B%04u>\r\n", serNoB % 10000);
+        LOG_I("<B%04u>", serNoB % 10000);
         F3F_TiggleBaseB(serNoB++);
         yield();
         buzzerStart();
@@ -229,23 +240,17 @@ void WiFiGotIP(WiFiEvent_t event, WiFiEventInfo_t info)
         Serial.println();
 #endif
         uint8_t *p = packet.data();
-        if(p[0] == '<' && p[6] == '>') {
-          if(p[1] == 'A') {
-            uint8_t buf[5];
-            memcpy(buf, &p[2], 4);
-            buf[4] = 0;
-            uint32_t serNo = atoi((const char *)buf) % 10000;
+        uint8_t base;
+        uint32_t serNo;
+        if(Remote_ParseBase(p, packet.length(), &base, &serNo)) {
+          if(base == 'A') {
             if(serNo != serNoA) {
               buzzerStart();
               F3F_TiggleBaseA(serNo);
               yield();
               serNoA = serNo;              
             }
-          } else if(p[1] == 'B') {
-            uint8_t buf[5];
-            memcpy(buf, &p[2], 4);
-            buf[4] = 0;
-            uint32_t serNo = atoi((const char *)buf) % 10000;
+          } else {
             if(serNo != serNoB) {
               buzzerStart();
               F3F_TiggleBaseB(serNo);
@@ -253,7 +258,8 @@ void WiFiGotIP(WiFiEvent_t event, WiFiEventInfo_t info)
               serNoB = serNo;
             }
           }
-        }
+        } else
+          Anemometer_Feed(p, packet.length()); /* MODBUS-ASCII from the anemometer bridge */
       }
     });    
   }
@@ -347,19 +353,74 @@ void mcastSetup()
   Serial.println("Wait for WiFi... ");
 }
 
-HeadLineType s_headLine = showCpuUsage;
+HeadLineType s_headLine = showWifi;
 
-void mcastLoop(){
+/* Access point, signal and IP address */
+void wifiPage()
+{
+  if(WiFi.status() == WL_CONNECTED) {
+    lcdPrintRow(0, "AP: %s (%d)", WiFi.SSID(), WiFi.RSSI());
+    lcdPrintRow(1, "IP: %s", WiFi.localIP().toString());
+  }
+}
+
+void wifiLoop()
+{
   static uint32_t lastTime = 0;
   if(WiFi.status() == WL_CONNECTED) {
     if(millis() - lastTime >= 1000) {
-      if(s_headLine == showCpuUsage)
+      if(s_headLine == showWifi)
         lcdPrintRow(0, "AP: %s (%d)", WiFi.SSID(), WiFi.RSSI());
       lastTime = millis();
     }
   }
 }
 
+/*
+* CPU
+*/
+
+/* Busy share of both cores and the longest loop() and F3F_Task pass, in ms */
+void cpuPage()
+{
+  CpuStats s;
+
+  Cpu_Stats(&s);
+  if(s.idle[0] == CPU_UNKNOWN || s.idle[1] == CPU_UNKNOWN)
+    lcdPrintRow(0, "CPU n/a");
+  else
+    lcdPrintRow(0, "CPU0 %2u%%  CPU1 %2u%%", 100 - s.idle[0], 100 - s.idle[1]);
+  lcdPrintRow(1, "loop %3u F3F %3u ms", (unsigned)(s.loopMax[CPU_LOOP_MAIN] + 999) / 1000,
+    (unsigned)(s.loopMax[CPU_LOOP_F3F] + 999) / 1000);
+}
+
+void cpuLoop()
+{
+  static uint32_t lastTime = 0;
+  if(millis() - lastTime >= CPU_WINDOW_MS) {
+    if(s_headLine == showCpuUsage)
+      cpuPage();
+    lastTime = millis();
+  }
+}
+
+/* One letter commands on the serial port */
+void serialLoop()
+{
+  while(Serial.available() > 0) {
+    switch(Serial.read()) {
+      case 'c':
+        Cpu_Dump();
+        break;
+      case 'm':
+        Telemetry_Dump();
+        break;
+      default:
+        break;
+    }
+  }
+}
+
 /*
 * F3F
 */
@@ -401,6 +462,7 @@ void setup() {
 	timerAlarm(timer1, 1000L, true, 0);            // 1000 * 1us = 1ms, single shot
 */
   Serial.begin(115200);
+  Log_Init();
 
   lcd2004Setup();
 
@@ -414,18 +476,27 @@ void setup() {
     while(true); 
   }
 
+  FlightLog_Init();
+  Trace_Init();
+  Competition_Load(COMPETITION_PILOTS_PATH);
+  Anemometer_Init();
+
   crsfSetup();
   buzzerSetup();
   mcastSetup();
+  HttpExport_Init();
+  Status_Init();
+  Cpu_Init();
+  Telemetry_Init();
 
   F3F_Init([](HeadLineType type) {
     s_headLine = type;
     switch(type) {
+      case showWifi:
+        wifiPage();
+        break;
       case showCpuUsage:
-        if(WiFi.status() == WL_CONNECTED) {
-          lcdPrintRow(0, "AP: %s (%d)", WiFi.SSID(), WiFi.RSSI());
-          lcdPrintRow(1, "IP: %s", WiFi.localIP().toString());        
-        }
+        cpuPage();
         break;
       case showLastRecord:
         lcdPrintRow(0, "Last record %s", F3F_LastRecord());
@@ -444,6 +515,16 @@ void setup() {
       case showVolume: 
         lcdPrintRow(0, "Volume : %d dbm", Mp3Player_GetVolume());
         break;
+      case showStandings: {
+        const char *name;
+        uint32_t points;
+        for(uint8_t i = 0; i < 2; i++) {
+          if(Competition_Standing(i, &name, &points))
+            lcdPrintRow(i, "%u %-10.10s%5u.%02u", i + 1, name, (unsigned)(points / 100), (unsigned)(points % 100));
+          else
+            lcdPrintRow(i, i ? "" : "No pilots");
+        }
+        } break;
       default:
         break;
     }
@@ -458,9 +539,15 @@ void setup() {
     NULL,               // Task handle
     1          // Core you want to run the task on (0 or 1)
   );
+
+#ifdef LATENCY_BENCHMARK
+  Latency_Init();
+#endif
 }
 
 void loop() {
+  Cpu_LoopMark(CPU_LOOP_MAIN);
+
   if(digitalRead(BTN_START) == LOW) {
     F3F_KeyStart();
     //buzzerStart();
@@ -495,7 +582,9 @@ void loop() {
 
   lcd2004Loop();
   crsfLoop();
-  mcastLoop();
+  wifiLoop();
+  cpuLoop();
+  serialLoop();
   buzzerLoop();
 }
 /*
@@ -0,0 +1,158 @@
+#include <string.h>
+#include "modbus.h"
+
+/*
+* Table driven, every input byte is classified by modbusChar[] and the pair
+* (state, class) looks up the next state and an action in modbusNext[], so a
+* byte costs two table reads and no branching on the grammar.
+*
+* A frame is ':' then hex pairs up to CR LF, the last byte is the LRC, the two's
+* complement of the sum of the others, so the sum of all of them is 0.
+*/
+enum { cHex, cColon, cCr, cLf, cText, cO, cR, cBad, cCount };
+
+enum {
+	sIdle,      /* waiting for ':' */
+	sStart,     /* after ':', hex or text */
+	sHi,        /* high nibble of the next byte or CR */
+	sLo,        /* low nibble */
+	sText,
+	sHexCr,     /* CR seen, LF ends the frame */
+	sTextCr,
+	sO,         /* ":O", ":OO" and ":OOR", the one text line with a ':' in it */
+	sOO,
+	sOOR
+};
+
+enum {
+	aNone,
+	aStart,     /* ':' begins a frame */
+	aResync,    /* ':' in the middle of a frame or line, drop it and begin a new one */
+	aHi,
+	aLo,
+	aText,
+	aFrame,
+	aTextEnd,
+	aError
+};
+
+#define T(state, action) (uint8_t)(((action) << 4) | (state))
+
+/*
+* A ':' resyncs from every state but the one after ":OOR", so a text line that
+* lost its CR LF costs no frame. Only ":OOR:" followed by a ':' can take one.
+*/
+static const uint8_t modbusNext[][cCount] = {
+	/*              cHex             cColon             cCr               cLf                cText            cO               cR               cBad */
+	/* sIdle   */ { T(sIdle, aNone),  T(sStart, aStart),  T(sIdle, aNone),  T(sIdle, aNone),   T(sIdle, aNone),  T(sIdle, aNone),  T(sIdle, aNone),  T(sIdle, aNone) },
+	/* sStart  */ { T(sLo, aHi),      T(sStart, aStart),  T(sIdle, aError), T(sIdle, aError),  T(sText, aText),  T(sO, aText),     T(sText, aText),  T(sIdle, aError) },
+	/* sHi     */ { T(sLo, aHi),      T(sStart, aResync), T(sHexCr, aNone), T(sIdle, aError),  T(sIdle, aError), T(sIdle, aError), T(sIdle, aError), T(sIdle, aError) },
+	/* sLo     */ { T(sHi, aLo),      T(sStart, aResync), T(sIdle, aError), T(sIdle, aError),  T(sIdle, aError), T(sIdle, aError), T(sIdle, aError), T(sIdle, aError) },
+	/* sText   */ { T(sText, aText),  T(sStart, aResync), T(sTextCr, aNone), T(sIdle, aError), T(sText, aText),  T(sText, aText),  T(sText, aText),  T(sIdle, aError) },
+	/* sHexCr  */ { T(sIdle, aError), T(sStart, aResync), T(sIdle, aError), T(sIdle, aFrame),  T(sIdle, aError), T(sIdle, aError), T(sIdle, aError), T(sIdle, aError) },
+	/* sTextCr */ { T(sIdle, aError), T(sStart, aResync), T(sIdle, aError), T(sIdle, aTextEnd), T(sIdle, aError), T(sIdle, aError), T(sIdle, aError), T(sIdle, aError) },
+	/* sO      */ { T(sText, aText),  T(sStart, aResync), T(sTextCr, aNone), T(sIdle, aError), T(sText, aText),  T(sOO, aText),    T(sText, aText),  T(sIdle, aError) },
+	/* sOO     */ { T(sText, aText),  T(sStart, aResync), T(sTextCr, aNone), T(sIdle, aError), T(sText, aText),  T(sText, aText),  T(sOOR, aText),   T(sIdle, aError) },
+	/* sOOR    */ { T(sText, aText),  T(sText, aText),    T(sTextCr, aNone), T(sIdle, aError), T(sText, aText),  T(sText, aText),  T(sText, aText),  T(sIdle, aError) },
+};
+
+#undef T
+
+/* class in the high nibble, hex value in the low one */
+#define H(v) (uint8_t)((cHex << 4) | (v))
+#define COL  (uint8_t)(cColon << 4)
+#define CR   (uint8_t)(cCr << 4)
+#define LF   (uint8_t)(cLf << 4)
+#define TXT  (uint8_t)(cText << 4)
+#define OCH  (uint8_t)(cO << 4)
+#define RCH  (uint8_t)(cR << 4)
+#define BAD  (uint8_t)(cBad << 4)
+
+static const uint8_t modbusChar[256] = {
+	BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   LF,    BAD,   BAD,   CR,    BAD,   BAD, /* 0x00 */
+	BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD, /* 0x10 */
+	BAD,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT, /*  !"#$%&'() +,-. */
+	H(0),  H(1),  H(2),  H(3),  H(4),  H(5),  H(6),  H(7),  H(8),  H(9),  COL,   TXT,   TXT,   TXT,   TXT,   TXT, /* 0123456789:;<=>? */
+	TXT,   H(10), H(11), H(12), H(13), H(14), H(15), TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   OCH, /* @ABCDEFGHIJKLMNO */
+	TXT,   TXT,   RCH,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT, /* PQRSTUVWXYZ[\]^_ */
+	TXT,   H(10), H(11), H(12), H(13), H(14), H(15), TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT, /* `abcdefghijklmno */
+	TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   TXT,   BAD, /* pqrstuvwxyz{|}~ */
+	BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD, /* 0x80 */
+	BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD, /* 0x90 */
+	BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD, /* 0xa0 */
+	BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD, /* 0xb0 */
+	BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD, /* 0xc0 */
+	BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD, /* 0xd0 */
+	BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD, /* 0xe0 */
+	BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD,   BAD, /* 0xf0 */
+};
+
+#undef H
+#undef COL
+#undef CR
+#undef LF
+#undef TXT
+#undef OCH
+#undef RCH
+#undef BAD
+
+void ModbusAscii_Reset(ModbusAscii *m)
+{
+	memset(m, 0, sizeof(ModbusAscii));
+	m->state = sIdle;
+}
+
+ModbusResult ModbusAscii_Feed(ModbusAscii *m, uint8_t c)
+{
+	uint8_t ch = modbusChar[c];
+	uint8_t next = modbusNext[m->state][ch >> 4];
+
+	m->state = next & 0x0f;
+
+	switch(next >> 4) {
+	case aStart:
+		m->len = 0;
+		m->lrc = 0;
+		return modbusNone;
+
+	case aResync:
+		m->len = 0;
+		m->lrc = 0;
+		return modbusError;
+
+	case aHi:
+		if(m->len >= MODBUS_ASCII_MAX)
+			break;
+		m->hi = ch & 0x0f;
+		return modbusNone;
+
+	case aLo:
+		m->data[m->len] = (m->hi << 4) | (ch & 0x0f);
+		m->lrc += m->data[m->len++];
+		return modbusNone;
+
+	case aText:
+		if(m->len >= MODBUS_ASCII_MAX)
+			break;
+		m->data[m->len++] = c;
+		return modbusNone;
+
+	case aFrame:
+		if(m->len < 2 || m->lrc != 0)
+			return modbusError;
+		m->len--; /* the LRC is not data */
+		return modbusFrame;
+
+	case aTextEnd:
+		return modbusText;
+
+	case aError:
+		return modbusError;
+
+	default:
+		return modbusNone;
+	}
+
+	m->state = sIdle; /* overflow */
+	return modbusError;
+}
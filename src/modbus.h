@@ -0,0 +1,31 @@
+#ifndef MODBUS_H
+#define MODBUS_H
+
+#include <stdint.h>
+
+#define MODBUS_ASCII_MAX 64     /* bytes of a frame, address to LRC */
+
+typedef enum {
+	modbusNone,     /* frame not complete yet */
+	modbusFrame,    /* data[0..len) holds address, function and payload, LRC checked */
+	modbusText,     /* a ':' line that is not hex, e.g. ":OOR:1", data holds the text */
+	modbusError     /* bad LRC, bad character or overflow, the frame is dropped */
+} ModbusResult;
+
+/*
+* Incremental MODBUS-ASCII parser, bytes can come in any chunks. A ':' starts a
+* new frame so a lost byte costs one frame, also inside a text line. The ':'
+* of ":OOR:n" is known by the prefix, it is the only text taken for a ':'.
+*/
+typedef struct {
+	uint8_t state;
+	uint8_t hi;             /* high nibble of the byte being decoded */
+	uint8_t lrc;
+	uint8_t len;
+	uint8_t data[MODBUS_ASCII_MAX];
+} ModbusAscii;
+
+void ModbusAscii_Reset(ModbusAscii *m);
+ModbusResult ModbusAscii_Feed(ModbusAscii *m, uint8_t c);
+
+#endif
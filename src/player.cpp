@@ -2,6 +2,9 @@
 #include <Audio.h>
 
 #include "player.h"
+#include "log.h"
+#include "latency.h"
+#include "telemetry.h"
 
 Audio audio;
 
@@ -29,7 +32,7 @@ static Mp3Context *Mp3Context_Create(const char *filePath)
 		if(filePath)
 			strncpy(c->filePath, filePath, FILE_PATH_SIZE);
 	} else
-		Serial.printf("pvPortMalloc fali\r\n");
+		LOG_E("pvPortMalloc fail");
 
 	return c;
 }
@@ -40,12 +43,18 @@ static void Mp3Context_Destroy(Mp3Context *c)
 		vPortFree(c);
 }
 
+static Mp3Context *pMp3Context = 0;
+static Mp3Context *pMp3PriorityContext = 0;
+
 static String currentFilePath; 
 
 static bool Mp3Context_Play(Mp3Context *c)
 {
     currentFilePath = c->filePath;
-    return audio.connecttoFS(SD, c->filePath);
+    bool r = audio.connecttoFS(SD, c->filePath);
+    if(r && c == pMp3PriorityContext)
+        LATENCY_MARK(LATENCY_OPEN);
+    return r;
 }
 
 static const char *Mp3Context_CurrentPlayFile()
@@ -56,13 +65,35 @@ static const char *Mp3Context_CurrentPlayFile()
         return nullptr; 
 }
 
-static Mp3Context *pMp3Context = 0;
-static Mp3Context *pMp3PriorityContext = 0;
-
 static xQueueHandle eventQueue;
 static xQueueHandle mp3ContextQueue;
 static xQueueHandle mp3PriorityContextQueue;
 
+#define HEADER_INDEX_PATH "/audio.idx"
+
+static void Mp3Player_IndexDir(const char *dirPath)
+{
+	File dir = SD.open(dirPath);
+	if(!dir)
+		return;
+	File f;
+	while((f = dir.openNextFile())) {
+		if(!f.isDirectory())
+			audio.indexAudioFile(SD, f.path());
+		f.close();
+	}
+	dir.close();
+}
+
+#ifdef LATENCY_BENCHMARK
+/* Every chunk on its way to I2S, defining it costs WAV files their zero copy path */
+void audio_process_i2s(int16_t *outBuff, uint16_t validSamples, uint8_t bitsPerSample, uint8_t channels, bool *continueI2S)
+{
+	*continueI2S = true;
+	LATENCY_MARK(LATENCY_I2S);
+}
+#endif
+
 void Mp3Player_Init(void)
 {
     // Setup I2S 
@@ -70,10 +101,21 @@ void Mp3Player_Init(void)
   
     // Set Volume
     audio.setVolume(21); // default 0...21
+
+	/* Parse every header once, remove /audio.idx from the SD card after changing the files */
+	if(audio.loadHeaderIndex(SD, HEADER_INDEX_PATH) == false) {
+		Mp3Player_IndexDir("/vocal");
+		Mp3Player_IndexDir("/music");
+		audio.saveHeaderIndex(SD, HEADER_INDEX_PATH);
+	}
+	Serial.printf("Header index %u files\r\n", audio.headerIndexSize());
   
 	eventQueue = xQueueCreate(32, sizeof(uint8_t));
 	mp3ContextQueue = xQueueCreate(16, sizeof(Mp3Context *));
 	mp3PriorityContextQueue = xQueueCreate(16, sizeof(Mp3Context *));
+	Telemetry_Queue("mp3Event", eventQueue);
+	Telemetry_Queue("mp3Context", mp3ContextQueue);
+	Telemetry_Queue("mp3Priority", mp3PriorityContextQueue);
 }
 
 void Mp3Player_Loop(void)
@@ -215,23 +257,28 @@ void Mp3Player_Play(const char *filePath)
 	if(c == 0)
 		return;
 
-    Serial.printf("%s:%d - %s\r\n", __FUNCTION__, __LINE__, c->filePath);
+    LOG_I("%s:%d - %s", __FUNCTION__, __LINE__, c->filePath);
 	xQueueSend(mp3ContextQueue, &c, portMAX_DELAY);
+	Telemetry_QueueSent(mp3ContextQueue);
 	uint8_t r = MP3_EVENT_PLAY;
 	xQueueSend(eventQueue, &r, 0);
+	Telemetry_QueueSent(eventQueue);
 	yield();
 }
 
 void Mp3Player_PlayPriority(const char *filePath)
 {
+	LATENCY_MARK(LATENCY_PLAY);
 	Mp3Context *c = Mp3Context_Create(filePath);
 	if(c == 0)
 		return;
 
-    Serial.printf("%s:%d - %s\r\n", __FUNCTION__, __LINE__, c->filePath);
+    LOG_I("%s:%d - %s", __FUNCTION__, __LINE__, c->filePath);
 	xQueueSend(mp3PriorityContextQueue, &c, portMAX_DELAY);
+	Telemetry_QueueSent(mp3PriorityContextQueue);
 	uint8_t r = MP3_EVENT_PRIORITY_PLAY;
 	xQueueSend(eventQueue, &r, 0);
+	Telemetry_QueueSent(eventQueue);
 	yield();
 }
 
@@ -240,6 +287,7 @@ void Mp3Player_Stop(void)
 	if(mp3State == mp3Playing || mp3State == mp3PriorityPlaying) {
 		uint8_t r = MP3_EVENT_STOP;
 		xQueueSend(eventQueue, &r, 0);
+		Telemetry_QueueSent(eventQueue);
 		yield();
 	}
 }
@@ -275,13 +323,13 @@ const char *Mp3Player_CurrentPlayFile()
 
 uint8_t Mp3Player_GetVolume()
 {
-Serial.printf("audio.getVolume() = %d\r\n", audio.getVolume());
+    LOG_D("audio.getVolume() = %d", audio.getVolume());
     return audio.getVolume();
 }
 
 void Mp3Player_SetVolume(uint8_t volume)
 {
-Serial.printf("volume = %d\r\n", volume);
+    LOG_D("volume = %d", volume);
     if(volume > audio.maxVolume())
         volume = audio.maxVolume();
     audio.setVolume(volume);
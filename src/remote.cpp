@@ -0,0 +1,18 @@
+#include "remote.h"
+
+/* Reads nothing past len, anything but the exact layout is not a base */
+bool Remote_ParseBase(const uint8_t *p, size_t len, uint8_t *base, uint32_t *serNo)
+{
+	if(len < REMOTE_BASE_SIZE || p[0] != '<' || p[6] != '>' || (p[1] != 'A' && p[1] != 'B'))
+		return false;
+
+	uint32_t n = 0;
+	for(int i = 2; i < 6; i++) {
+		if(p[i] < '0' || p[i] > '9')
+			return false;
+		n = n * 10 + (p[i] - '0');
+	}
+	*base = p[1];
+	*serNo = n;
+	return true;
+}
@@ -0,0 +1,16 @@
+#ifndef REMOTE_H
+#define REMOTE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+* A base from the network, a multicast datagram "<A1234>" or "<B1234>" on port
+* 9003, the digits are the sequence number of the sender. Bytes after the '>'
+* are ignored.
+*/
+#define REMOTE_BASE_SIZE 7
+
+bool Remote_ParseBase(const uint8_t *p, size_t len, uint8_t *base, uint32_t *serNo); /* base 'A' or 'B' */
+
+#endif
@@ -0,0 +1,118 @@
+#include <Arduino.h>
+#include "WiFi.h"
+#include "AsyncUDP.h"
+#include "status.h"
+
+/*
+* While the clock runs a delta is the mask and one or two bytes of time, 5 or 6
+* bytes in all, so 20 packets a second cost little airtime. An idle timer sends
+* once a second unless something changes.
+*/
+static AsyncUDP statusUdp;
+
+static size_t Status_Put32(uint8_t *p, uint32_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+	return 4;
+}
+
+static size_t Status_PutVarint(uint8_t *p, uint32_t v)
+{
+	size_t n = 0;
+
+	while(v >= 0x80) {
+		p[n++] = (v & 0x7f) | 0x80;
+		v >>= 7;
+	}
+	p[n++] = v;
+	return n;
+}
+
+size_t Status_Encode(const F3fStatus *prev, const F3fStatus *cur, uint8_t seq, uint8_t *buf)
+{
+	size_t n = 0;
+
+	buf[n++] = STATUS_MAGIC;
+	buf[n++] = STATUS_VERSION | (prev ? 0 : STATUS_KEY);
+	buf[n++] = seq;
+
+	if(prev == NULL) {
+		buf[n++] = cur->state;
+		buf[n++] = cur->mode;
+		buf[n++] = cur->legs;
+		n += Status_Put32(&buf[n], cur->time_ms);
+		n += Status_Put32(&buf[n], cur->last_ms);
+		return n;
+	}
+
+	uint8_t *mask = &buf[n++];
+	*mask = 0;
+	if(cur->state != prev->state) {
+		*mask |= STATUS_STATE;
+		buf[n++] = cur->state;
+	}
+	if(cur->mode != prev->mode) {
+		*mask |= STATUS_MODE;
+		buf[n++] = cur->mode;
+	}
+	if(cur->legs != prev->legs) {
+		*mask |= STATUS_LEGS;
+		buf[n++] = cur->legs;
+	}
+	if(cur->time_ms != prev->time_ms) {
+		int32_t d = (int32_t)(cur->time_ms - prev->time_ms);
+		*mask |= STATUS_TIME;
+		n += Status_PutVarint(&buf[n], ((uint32_t)d << 1) ^ (uint32_t)(d >> 31));
+	}
+	if(cur->last_ms != prev->last_ms) {
+		*mask |= STATUS_LAST;
+		n += Status_PutVarint(&buf[n], cur->last_ms);
+	}
+	return n;
+}
+
+static void Status_Task(void *pvParameters)
+{
+	F3fStatus sent, cur;
+	uint32_t sentTick = 0, keyTick = 0;
+	uint8_t seq = 0;
+	bool first = true;
+
+	for(;;) {
+		vTaskDelay(pdMS_TO_TICKS(10));
+		if(WiFi.status() != WL_CONNECTED) {
+			first = true;
+			continue;
+		}
+
+		F3F_Status(&cur);
+		uint32_t now = millis();
+		bool running = (cur.state == f3fThirtySecond || cur.state == f3fCourse);
+		bool changed = first || cur.state != sent.state || cur.mode != sent.mode || cur.legs != sent.legs || cur.last_ms != sent.last_ms;
+
+		/* at most 20 Hz, a change goes out at once, otherwise the rate of the state */
+		if(now - sentTick < STATUS_RUNNING_MS)
+			continue;
+		if(!changed && now - sentTick < (running ? STATUS_RUNNING_MS : STATUS_IDLE_MS))
+			continue;
+
+		bool key = first || now - keyTick >= STATUS_KEY_MS;
+		uint8_t buf[STATUS_PACKET_MAX];
+		size_t len = Status_Encode(key ? NULL : &sent, &cur, seq++, buf);
+
+		statusUdp.writeTo(buf, len, IPAddress(224, 0, 0, 3), STATUS_GROUP_PORT);
+		sent = cur;
+		sentTick = now;
+		if(key)
+			keyTick = now;
+		first = false;
+	}
+}
+
+void Status_Init()
+{
+	xTaskCreatePinnedToCore(Status_Task, "Status_Task", 3072, NULL, 1, NULL, 0);
+}
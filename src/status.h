@@ -0,0 +1,42 @@
+#ifndef STATUS_H
+#define STATUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "f3f.h"
+
+/*
+* Live status for remote scoreboards, multicast next to the base triggers.
+*
+*   0     STATUS_MAGIC
+*   1     bit 7 key frame, bits 0..6 STATUS_VERSION
+*   2     seq, one more than the previous packet
+*   key   state, mode, legs, time_ms and last_ms as 32 bit little endian
+*   delta mask of STATUS_xxx, then only the fields that changed since packet
+*         seq - 1: state, mode, legs a byte each, time_ms as a zigzag varint
+*         of the difference, last_ms as a varint
+*
+* A receiver that missed a packet waits for the next key frame, one per second.
+*/
+#define STATUS_GROUP_PORT 9004          /* on 224.0.0.3, the triggers use 9003 */
+#define STATUS_MAGIC      0xf3
+#define STATUS_VERSION    1
+#define STATUS_KEY        0x80
+#define STATUS_PACKET_MAX 20
+
+#define STATUS_STATE (1 << 0)
+#define STATUS_MODE  (1 << 1)
+#define STATUS_LEGS  (1 << 2)
+#define STATUS_TIME  (1 << 3)
+#define STATUS_LAST  (1 << 4)
+
+#define STATUS_RUNNING_MS 50            /* 20 Hz while the clock runs */
+#define STATUS_IDLE_MS    1000
+#define STATUS_KEY_MS     1000
+
+/* prev is the last packet sent, NULL for a key frame, returns the packet length */
+size_t Status_Encode(const F3fStatus *prev, const F3fStatus *cur, uint8_t seq, uint8_t *buf);
+
+void Status_Init();
+
+#endif
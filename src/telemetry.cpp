@@ -0,0 +1,236 @@
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include "telemetry.h"
+#include "log.h"
+
+/*
+* FreeRTOS keeps no peak of a queue, the sender reads the depth right after
+* it sent. Two senders of one queue can race on the peak, the one that loses
+* was at most one item deeper. The queues register at boot, before the task
+* that reads them runs, the list only grows.
+*
+* Every limit has an alert flag, a warning goes out when the flag rises. A
+* task is matched to its flag of the last sample by handle, as in cpu.cpp.
+*/
+#define TELEMETRY_HEAPS 2
+
+typedef struct {
+	const char *name;
+	uint32_t caps;
+	bool alertMin;
+	bool alertBlock;
+} TelemetryHeapSource;
+
+typedef struct {
+	uint32_t total;
+	uint32_t free;
+	uint32_t minFree;
+	uint32_t largest;
+} TelemetryHeap;
+
+typedef struct {
+	const void *handle;
+	char name[16];
+	uint32_t stackFree;         /* bytes */
+	bool alert;
+} TelemetryTask;
+
+typedef struct {
+	const char *name;
+	void *queue;
+	uint16_t size;
+	volatile uint16_t peak;
+	bool alert;
+} TelemetryQueue;
+
+typedef struct {
+	TelemetryHeap heap[TELEMETRY_HEAPS];
+	int16_t tasks;              /* -1 built without the trace facility */
+	TelemetryTask task[TELEMETRY_TASKS_MAX];
+	uint16_t depth[TELEMETRY_QUEUES_MAX];
+	uint16_t peak[TELEMETRY_QUEUES_MAX];
+} TelemetryStats;
+
+static TelemetryHeapSource heapSources[TELEMETRY_HEAPS] = {
+	{ "internal", MALLOC_CAP_INTERNAL, false, false },
+	{ "psram", MALLOC_CAP_SPIRAM, false, false },
+};
+
+static TelemetryQueue queues[TELEMETRY_QUEUES_MAX];
+static volatile uint8_t queueCount = 0;
+
+static TelemetryStats telemetryStats;
+static portMUX_TYPE telemetryMux = portMUX_INITIALIZER_UNLOCKED;
+
+/* true when the flag rises */
+static bool Telemetry_Alert(bool *alert, bool low)
+{
+	bool rise = low && !*alert;
+	*alert = low;
+	return rise;
+}
+
+void Telemetry_Queue(const char *name, void *queue)
+{
+	if(queue == NULL)
+		return;
+
+	portENTER_CRITICAL(&telemetryMux);
+	if(queueCount < TELEMETRY_QUEUES_MAX) {
+		TelemetryQueue *e = &queues[queueCount];
+		e->name = name;
+		e->queue = queue;
+		e->size = uxQueueMessagesWaiting((QueueHandle_t)queue) + uxQueueSpacesAvailable((QueueHandle_t)queue);
+		e->peak = 0;
+		e->alert = false;
+		queueCount++;
+	}
+	portEXIT_CRITICAL(&telemetryMux);
+}
+
+void Telemetry_QueueSent(void *queue)
+{
+	for(uint8_t i = 0; i < queueCount; i++) {
+		TelemetryQueue *e = &queues[i];
+		if(e->queue != queue)
+			continue;
+		uint16_t depth = uxQueueMessagesWaiting((QueueHandle_t)queue);
+		if(depth > e->peak)
+			e->peak = depth;
+		return;
+	}
+}
+
+static void Telemetry_SampleHeaps(TelemetryStats *s)
+{
+	for(uint8_t i = 0; i < TELEMETRY_HEAPS; i++) {
+		TelemetryHeapSource *src = &heapSources[i];
+		TelemetryHeap *h = &s->heap[i];
+
+		h->total = heap_caps_get_total_size(src->caps);
+		h->free = heap_caps_get_free_size(src->caps);
+		h->minFree = heap_caps_get_minimum_free_size(src->caps);
+		h->largest = heap_caps_get_largest_free_block(src->caps);
+		if(h->total == 0)
+			continue; /* no PSRAM on the board */
+
+		if(Telemetry_Alert(&src->alertMin, h->minFree < TELEMETRY_HEAP_LOW))
+			LOG_W("Heap %s down to %u bytes free, of %u", src->name, (unsigned)h->minFree, (unsigned)h->total);
+		if(Telemetry_Alert(&src->alertBlock, h->largest < TELEMETRY_BLOCK_LOW))
+			LOG_W("Heap %s largest free block %u bytes, %u free", src->name, (unsigned)h->largest, (unsigned)h->free);
+	}
+}
+
+#if configUSE_TRACE_FACILITY
+static TaskStatus_t telemetryStatus[TELEMETRY_TASKS_MAX];
+static TelemetryTask telemetryLast[TELEMETRY_TASKS_MAX];
+static uint8_t telemetryLastCount = 0;
+
+static bool Telemetry_LastAlert(TaskHandle_t handle)
+{
+	for(uint8_t i = 0; i < telemetryLastCount; i++) {
+		if(telemetryLast[i].handle == handle)
+			return telemetryLast[i].alert;
+	}
+	return false;
+}
+
+static void Telemetry_SampleTasks(TelemetryStats *s)
+{
+	UBaseType_t n = uxTaskGetSystemState(telemetryStatus, TELEMETRY_TASKS_MAX, NULL);
+
+	s->tasks = 0;
+	if(n == 0) {
+		LOG_W("More than %u tasks, no stack sample", TELEMETRY_TASKS_MAX);
+		return;
+	}
+
+	for(UBaseType_t i = 0; i < n; i++) {
+		TaskStatus_t *ts = &telemetryStatus[i];
+		TelemetryTask *t = &s->task[s->tasks++];
+
+		t->handle = ts->xHandle;
+		snprintf(t->name, sizeof(t->name), "%s", ts->pcTaskName);
+		t->stackFree = ts->usStackHighWaterMark; /* StackType_t is a byte on ESP-IDF */
+		t->alert = Telemetry_LastAlert(ts->xHandle);
+		if(Telemetry_Alert(&t->alert, t->stackFree < TELEMETRY_STACK_LOW))
+			LOG_W("Task %s has %u bytes of stack left", t->name, (unsigned)t->stackFree);
+	}
+
+	memcpy(telemetryLast, s->task, n * sizeof(TelemetryTask));
+	telemetryLastCount = n;
+}
+#else
+static void Telemetry_SampleTasks(TelemetryStats *s)
+{
+	s->tasks = -1;
+}
+#endif
+
+static void Telemetry_SampleQueues(TelemetryStats *s)
+{
+	for(uint8_t i = 0; i < queueCount; i++) {
+		TelemetryQueue *e = &queues[i];
+
+		s->depth[i] = uxQueueMessagesWaiting((QueueHandle_t)e->queue);
+		s->peak[i] = e->peak;
+		if(Telemetry_Alert(&e->alert, s->peak[i] * 100 >= e->size * TELEMETRY_QUEUE_HIGH))
+			LOG_W("Queue %s peaked at %u of %u", e->name, s->peak[i], e->size);
+	}
+}
+
+static void telemetryTask(void *pvParameters)
+{
+	static TelemetryStats s; /* off the stack, telemetryTask is small */
+
+	for(;;) {
+		Telemetry_SampleHeaps(&s);
+		Telemetry_SampleTasks(&s);
+		Telemetry_SampleQueues(&s);
+
+		portENTER_CRITICAL(&telemetryMux);
+		telemetryStats = s;
+		portEXIT_CRITICAL(&telemetryMux);
+
+		vTaskDelay(pdMS_TO_TICKS(TELEMETRY_PERIOD_MS));
+	}
+}
+
+void Telemetry_Init()
+{
+	telemetryStats.tasks = -1;
+	xTaskCreatePinnedToCore(telemetryTask, "telemetryTask", 3072, NULL, 1, NULL, 0);
+}
+
+void Telemetry_Dump()
+{
+	static TelemetryStats s;
+	uint8_t order[TELEMETRY_TASKS_MAX];
+
+	portENTER_CRITICAL(&telemetryMux);
+	s = telemetryStats;
+	portEXIT_CRITICAL(&telemetryMux);
+
+	for(uint8_t i = 0; i < TELEMETRY_HEAPS; i++) {
+		const TelemetryHeap *h = &s.heap[i];
+		if(h->total)
+			Serial.printf("heap %-8s %7u free %7u min %7u largest %7u total\r\n", heapSources[i].name,
+				(unsigned)h->free, (unsigned)h->minFree, (unsigned)h->largest, (unsigned)h->total);
+	}
+
+	if(s.tasks < 0)
+		Serial.printf("stack n/a\r\n");
+	for(int16_t i = 0; i < s.tasks; i++) { /* insertion sort, least stack left first */
+		int16_t j = i;
+		for(; j > 0 && s.task[order[j - 1]].stackFree > s.task[i].stackFree; j--)
+			order[j] = order[j - 1];
+		order[j] = i;
+	}
+	for(int16_t i = 0; i < s.tasks; i++) {
+		const TelemetryTask *t = &s.task[order[i]];
+		Serial.printf("stack %-16s %5u left%s\r\n", t->name, (unsigned)t->stackFree, t->alert ? " LOW" : "");
+	}
+
+	for(uint8_t i = 0; i < queueCount; i++)
+		Serial.printf("queue %-16s %3u now %3u peak %3u size\r\n", queues[i].name, s.depth[i], s.peak[i], queues[i].size);
+}
@@ -0,0 +1,27 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+/*
+* What the firmware can run out of, sampled every TELEMETRY_PERIOD_MS by a low
+* priority task: free, minimum free and largest free block of the internal heap
+* and of PSRAM, the stack high water mark of every task and the peak depth of
+* every registered queue. A resource that crosses its limit logs one warning,
+* the next one only after it recovered.
+*/
+#define TELEMETRY_PERIOD_MS  5000
+#define TELEMETRY_TASKS_MAX  24
+#define TELEMETRY_QUEUES_MAX 8
+
+#define TELEMETRY_HEAP_LOW   16384  /* bytes, the minimum free a heap ever had */
+#define TELEMETRY_BLOCK_LOW  4096   /* bytes, the largest block left in a heap */
+#define TELEMETRY_STACK_LOW  512    /* bytes of its stack a task never used */
+#define TELEMETRY_QUEUE_HIGH 75     /* % of a queue used at its peak */
+
+void Telemetry_Init();
+void Telemetry_Queue(const char *name, void *queue); /* after xQueueCreate(), before the first send */
+void Telemetry_QueueSent(void *queue);              /* after every send, any task */
+void Telemetry_Dump();                              /* the last sample to the serial port */
+
+#endif
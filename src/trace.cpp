@@ -0,0 +1,101 @@
+#include <Arduino.h>
+#include <SD.h>
+#include <esp_timer.h>
+#include "trace.h"
+#include "log.h"
+
+/*
+* Events go into a RAM ring under a spinlock, whoever posts them (loop(), the
+* UDP callback, the CRSF poll) only copies 10 bytes. traceTask appends what
+* collected to the file once a second, a flight is a few dozen events so the
+* ring never fills unless the card stalls for a long time.
+*/
+#define TRACE_RING_SIZE 256     /* events, power of two */
+#define TRACE_FLUSH_MS  1000
+
+static TraceEvent traceRing[TRACE_RING_SIZE];
+static uint32_t traceHead = 0, traceTail = 0;
+static volatile uint32_t traceDropped = 0;
+static bool traceHeaderDone = false;
+static portMUX_TYPE traceMux = portMUX_INITIALIZER_UNLOCKED;
+
+void Trace_Event(uint8_t event, uint16_t serNo, uint8_t flags)
+{
+	int64_t t = esp_timer_get_time();
+
+	portENTER_CRITICAL(&traceMux);
+	if(traceHead - traceTail < TRACE_RING_SIZE) {
+		TraceEvent *e = &traceRing[traceHead++ & (TRACE_RING_SIZE - 1)];
+		e->ms = (uint32_t)(t / 1000);
+		e->us = (uint16_t)(t % 1000);
+		e->event = event;
+		e->flags = flags;
+		e->serNo = serNo;
+	} else
+		traceDropped++;
+	portEXIT_CRITICAL(&traceMux);
+}
+
+static void Trace_Flush()
+{
+	TraceEvent batch[32];
+	uint32_t n = 0;
+
+	portENTER_CRITICAL(&traceMux);
+	while(n < 32 && traceTail != traceHead)
+		batch[n++] = traceRing[traceTail++ & (TRACE_RING_SIZE - 1)];
+	portEXIT_CRITICAL(&traceMux);
+
+	if(n == 0)
+		return;
+
+	if(SD.exists(TRACE_PATH)) {
+		File f = SD.open(TRACE_PATH, FILE_READ);
+		size_t size = f ? f.size() : 0;
+		f.close();
+		if(size > TRACE_MAX_SIZE) {
+			SD.remove(TRACE_OLD_PATH);
+			SD.rename(TRACE_PATH, TRACE_OLD_PATH);
+			traceHeaderDone = false; /* a new file starts with a header */
+		}
+	}
+
+	File f = SD.open(TRACE_PATH, FILE_APPEND);
+	if(!f) {
+		LOG_E("Fail open %s", TRACE_PATH);
+		return;
+	}
+	if(!traceHeaderDone) {
+		TraceHeader h = { TRACE_MAGIC, TRACE_VERSION, sizeof(TraceEvent), 0 };
+		f.write((const uint8_t *)&h, sizeof(h));
+		traceHeaderDone = true;
+	}
+	f.write((const uint8_t *)batch, n * sizeof(TraceEvent));
+	f.close();
+}
+
+static void traceTask(void *pvParameters)
+{
+	uint32_t dropped = 0;
+
+	for(;;) {
+		vTaskDelay(pdMS_TO_TICKS(TRACE_FLUSH_MS));
+		while(traceTail != traceHead)
+			Trace_Flush();
+
+		if(dropped != traceDropped) {
+			LOG_W("%u trace events dropped", (unsigned)(traceDropped - dropped));
+			dropped = traceDropped;
+		}
+	}
+}
+
+void Trace_Init()
+{
+	xTaskCreatePinnedToCore(traceTask, "traceTask", 3072, NULL, 1, NULL, 0);
+}
+
+uint32_t Trace_Dropped()
+{
+	return traceDropped;
+}
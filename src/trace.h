@@ -0,0 +1,51 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+/*
+* Trigger trace, every key and base event that reaches the F3F task, for
+* replaying field incidents on the host (env:native, -r).
+*
+* The file is a TraceHeader and then TraceEvent records. Every boot writes a new
+* header, the times of the records after it count from that boot.
+*/
+#define TRACE_PATH     "/f3f/trigger.trc"
+#define TRACE_OLD_PATH "/f3f/trigger.old"
+#define TRACE_MAX_SIZE (1024 * 1024)    /* rotated to TRACE_OLD_PATH */
+
+#define TRACE_MAGIC   0x54463346        /* "F3FT" */
+#define TRACE_VERSION 1
+
+/* event */
+#define TRACE_START   0
+#define TRACE_A       1
+#define TRACE_B       2
+#define TRACE_STOP    3
+#define TRACE_BASE_A  4
+#define TRACE_BASE_B  5
+#define TRACE_REMOTE  0x80              /* base from the radio or the network */
+
+/* flags */
+#define TRACE_DROPPED (1 << 0)          /* the key queue was full */
+
+typedef struct __attribute__((packed)) {
+	uint32_t magic;
+	uint8_t version;
+	uint8_t size;                       /* sizeof(TraceEvent) */
+	uint16_t reserved;
+} TraceHeader;
+
+typedef struct __attribute__((packed)) {
+	uint32_t ms;                        /* millis(), the tick the F3F task sees */
+	uint16_t us;                        /* 0..999 on top of ms */
+	uint8_t event;
+	uint8_t flags;
+	uint16_t serNo;                     /* remote bases, sequence number of the sender */
+} TraceEvent;
+
+void Trace_Init();
+void Trace_Event(uint8_t event, uint16_t serNo, uint8_t flags); /* never blocks */
+uint32_t Trace_Dropped();
+
+#endif
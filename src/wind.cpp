@@ -0,0 +1,203 @@
+#include <Arduino.h>
+#include <math.h>
+#include "wind.h"
+
+/*
+* Wind samples in a ring, the rolling window is the samples younger than
+* windowMs. Sums give the mean and the sector share, monotonic queues of ring
+* positions give min and max, every sample is pushed and popped once so all
+* of it is O(1) per sample. Direction is averaged as a vector.
+*/
+typedef struct {
+	uint32_t tick;
+	uint16_t speed;         /* cm/s */
+	uint16_t dir;           /* degrees */
+	uint8_t inSector;
+} WindSample;
+
+typedef struct {
+	uint32_t q[WIND_RING_SIZE]; /* ring positions, values monotonic from head to tail */
+	uint32_t head, tail;
+} WindQueue;
+
+static WindSample ring[WIND_RING_SIZE];
+static uint32_t ringHead = 0, ringTail = 0;     /* window is [ringHead, ringTail) */
+static WindQueue minQueue, maxQueue;
+static uint32_t speedSum = 0;
+static uint32_t sectorCount = 0;
+static float dirX = 0, dirY = 0;
+
+static uint32_t windowMs = WIND_WINDOW_MS;
+static int16_t slopeDir = WIND_SLOPE_DIR;
+
+/* start of a condition that breaks a rule, 0 while it does not hold */
+static uint32_t lowSince = 0, highSince = 0, dirSince = 0;
+static uint8_t alerts = 0;
+
+static struct {
+	uint32_t samples, speedSum, sectorCount;
+	uint16_t min, max;
+	float dirX, dirY;
+	uint8_t alerts;
+} flight;
+
+static portMUX_TYPE windMux = portMUX_INITIALIZER_UNLOCKED;
+
+#define RING(i) ring[(i) & (WIND_RING_SIZE - 1)]
+
+static void WindQueue_Push(WindQueue *wq, uint32_t pos, bool isMin)
+{
+	uint16_t v = RING(pos).speed;
+
+	while(wq->tail != wq->head) {
+		uint16_t b = RING(wq->q[(wq->tail - 1) & (WIND_RING_SIZE - 1)]).speed;
+		if(isMin ? (b < v) : (b > v))
+			break;
+		wq->tail--;
+	}
+	wq->q[wq->tail++ & (WIND_RING_SIZE - 1)] = pos;
+}
+
+static void WindQueue_Pop(WindQueue *wq, uint32_t pos)
+{
+	if(wq->tail != wq->head && wq->q[wq->head & (WIND_RING_SIZE - 1)] == pos)
+		wq->head++;
+}
+
+static bool Wind_InSector(uint16_t dir)
+{
+	if(slopeDir < 0)
+		return true;
+	int d = abs((int)dir - slopeDir) % 360;
+	if(d > 180)
+		d = 360 - d;
+	return d <= WIND_SECTOR_DEG;
+}
+
+static void Wind_Evict()
+{
+	WindSample *s = &RING(ringHead);
+
+	speedSum -= s->speed;
+	sectorCount -= s->inSector;
+	dirX -= cosf(s->dir * (float)DEG_TO_RAD);
+	dirY -= sinf(s->dir * (float)DEG_TO_RAD);
+	WindQueue_Pop(&minQueue, ringHead);
+	WindQueue_Pop(&maxQueue, ringHead);
+	ringHead++;
+}
+
+static uint32_t Wind_Rule(bool broken, uint32_t since, uint32_t tick, uint8_t alert)
+{
+	if(!broken) {
+		alerts &= ~alert;
+		return 0;
+	}
+	if(since == 0)
+		since = tick ? tick : 1;
+	if(tick - since >= WIND_RULE_MS)
+		alerts |= alert;
+	return since;
+}
+
+void Wind_Config(uint32_t ms, int16_t dir)
+{
+	portENTER_CRITICAL(&windMux);
+	windowMs = ms;
+	slopeDir = dir;
+	portEXIT_CRITICAL(&windMux);
+}
+
+void Wind_Add(uint32_t tick, uint16_t speed, uint16_t dir)
+{
+	float x = cosf(dir * (float)DEG_TO_RAD);
+	float y = sinf(dir * (float)DEG_TO_RAD);
+
+	portENTER_CRITICAL(&windMux);
+
+	while(ringTail != ringHead && (ringTail - ringHead == WIND_RING_SIZE || tick - RING(ringHead).tick > windowMs))
+		Wind_Evict();
+
+	WindSample *s = &RING(ringTail);
+	s->tick = tick;
+	s->speed = speed;
+	s->dir = dir % 360;
+	s->inSector = Wind_InSector(s->dir) ? 1 : 0;
+	speedSum += speed;
+	sectorCount += s->inSector;
+	dirX += x;
+	dirY += y;
+	WindQueue_Push(&minQueue, ringTail, true);
+	WindQueue_Push(&maxQueue, ringTail, false);
+	ringTail++;
+
+	lowSince = Wind_Rule(speed < WIND_MIN_CMS, lowSince, tick, WIND_ALERT_LOW);
+	highSince = Wind_Rule(speed > WIND_MAX_CMS, highSince, tick, WIND_ALERT_HIGH);
+	dirSince = Wind_Rule(!s->inSector, dirSince, tick, WIND_ALERT_DIR);
+
+	flight.samples++;
+	flight.speedSum += speed;
+	flight.sectorCount += s->inSector;
+	flight.min = (flight.samples == 1 || speed < flight.min) ? speed : flight.min;
+	flight.max = (speed > flight.max) ? speed : flight.max;
+	flight.dirX += x;
+	flight.dirY += y;
+	flight.alerts |= alerts;
+
+	portEXIT_CRITICAL(&windMux);
+}
+
+static uint16_t Wind_Dir(float x, float y)
+{
+	int d = (int)lroundf(atan2f(y, x) * (float)RAD_TO_DEG);
+	return (d < 0) ? d + 360 : d;
+}
+
+bool Wind_Stats(WindStats *s)
+{
+	portENTER_CRITICAL(&windMux);
+	uint32_t n = ringTail - ringHead;
+	if(n) {
+		s->samples = n;
+		s->mean = speedSum / n;
+		s->min = RING(minQueue.q[minQueue.head & (WIND_RING_SIZE - 1)]).speed;
+		s->max = RING(maxQueue.q[maxQueue.head & (WIND_RING_SIZE - 1)]).speed;
+		s->dir = Wind_Dir(dirX, dirY);
+		s->inSector = (sectorCount * 100) / n;
+	}
+	portEXIT_CRITICAL(&windMux);
+
+	return n != 0;
+}
+
+uint8_t Wind_Alerts()
+{
+	return alerts;
+}
+
+void Wind_FlightStart()
+{
+	portENTER_CRITICAL(&windMux);
+	memset(&flight, 0, sizeof(flight));
+	portEXIT_CRITICAL(&windMux);
+}
+
+uint8_t Wind_FlightStats(WindStats *s)
+{
+	uint8_t a;
+
+	portENTER_CRITICAL(&windMux);
+	memset(s, 0, sizeof(WindStats));
+	if(flight.samples) {
+		s->samples = (flight.samples > 0xffff) ? 0xffff : flight.samples;
+		s->mean = flight.speedSum / flight.samples;
+		s->min = flight.min;
+		s->max = flight.max;
+		s->dir = Wind_Dir(flight.dirX, flight.dirY);
+		s->inSector = (flight.sectorCount * 100) / flight.samples;
+	}
+	a = flight.alerts;
+	portEXIT_CRITICAL(&windMux);
+
+	return a;
+}
@@ -0,0 +1,38 @@
+#ifndef WIND_H
+#define WIND_H
+
+#include <stdint.h>
+
+#define WIND_RING_SIZE  256     /* samples, power of two */
+#define WIND_WINDOW_MS  20000   /* default rolling window */
+#define WIND_RULE_MS    20000   /* a condition must hold this long to raise an alert */
+#define WIND_MIN_CMS    300     /* F3F, below 3 m/s */
+#define WIND_MAX_CMS    2500    /* F3F, above 25 m/s */
+#define WIND_SECTOR_DEG 45      /* F3F, off the slope axis by more than 45 degrees */
+
+#ifndef WIND_SLOPE_DIR
+#define WIND_SLOPE_DIR  -1      /* degrees the wind should come from, -1 no direction check */
+#endif
+
+#define WIND_ALERT_LOW  (1 << 0)
+#define WIND_ALERT_HIGH (1 << 1)
+#define WIND_ALERT_DIR  (1 << 2)
+
+typedef struct {
+	uint16_t samples;
+	uint16_t mean;          /* cm/s */
+	uint16_t min;
+	uint16_t max;
+	uint16_t dir;           /* mean direction, degrees */
+	uint8_t inSector;       /* % of samples inside the slope sector */
+} WindStats;
+
+void Wind_Config(uint32_t windowMs, int16_t slopeDir);
+void Wind_Add(uint32_t tick, uint16_t speed, uint16_t dir);
+bool Wind_Stats(WindStats *s);      /* over the rolling window */
+uint8_t Wind_Alerts();              /* WIND_ALERT_xxx held for WIND_RULE_MS */
+
+void Wind_FlightStart();
+uint8_t Wind_FlightStats(WindStats *s); /* since Wind_FlightStart(), returns the alerts seen */
+
+#endif
@@ -0,0 +1,198 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "anemometer.h"
+#include "modbus.h"
+
+/*
+* The MODBUS-ASCII parser and the anemometer decoder on damaged input: a good
+* frame split at every byte, every single bit flip of it, and random noise with
+* good frames in between, in random chunks. A frame must come out whole
+* whatever the chunks, and damage must never turn into a wrong sample.
+*/
+static ModbusAscii m;
+static const AnemometerSample good = { 0, 525, 270, ANEMOMETER_OK };
+static char frame[32];
+static size_t frameLen;
+static int wrong;
+static uint32_t seed;
+
+static uint32_t Test_Random()
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+/* the answer to a register read, see anemometer.cpp */
+static size_t Test_Frame(char *buf, uint16_t dir, float speed)
+{
+	uint8_t d[10];
+	uint32_t bits;
+	uint8_t lrc = 0;
+
+	memcpy(&bits, &speed, sizeof(bits));
+	d[0] = 1;
+	d[1] = 3;
+	d[2] = 6;
+	d[3] = dir >> 8;
+	d[4] = dir;
+	d[5] = bits >> 8;
+	d[6] = bits;
+	d[7] = bits >> 24;
+	d[8] = bits >> 16;
+	for(int i = 0; i < 9; i++)
+		lrc += d[i];
+	d[9] = -lrc;
+
+	size_t n = 0;
+	buf[n++] = ':';
+	for(int i = 0; i < 10; i++)
+		n += sprintf(&buf[n], "%02X", d[i]);
+	buf[n++] = '\r';
+	buf[n++] = '\n';
+	return n;
+}
+
+/* returns samples decoded, the ones that do not match good count in wrong */
+static int Test_Feed(const uint8_t *p, size_t len, const AnemometerSample *expect)
+{
+	AnemometerSample s;
+	int n = 0;
+
+	for(size_t i = 0; i < len; i++) {
+		ModbusResult r = ModbusAscii_Feed(&m, p[i]);
+		if((r == modbusFrame || r == modbusText) && Anemometer_Decode(&m, r, 0, &s)) {
+			if(s.status != expect->status || s.speed != expect->speed || s.dir != expect->dir)
+				wrong++;
+			n++;
+		}
+	}
+	return n;
+}
+
+void setUp()
+{
+	ModbusAscii_Reset(&m);
+	frameLen = Test_Frame(frame, good.dir, 5.25f);
+	wrong = 0;
+	seed = 0x2545f491;
+}
+
+void tearDown() {}
+
+static void test_frame_decodes()
+{
+	TEST_ASSERT_EQUAL_INT(1, Test_Feed((const uint8_t *)frame, frameLen, &good));
+	TEST_ASSERT_EQUAL_INT(0, wrong);
+}
+
+static void test_out_of_range_lines()
+{
+	AnemometerSample speed = { 0, 0, 0, ANEMOMETER_SPEED_OOR };
+	AnemometerSample dir = { 0, 0, 0, ANEMOMETER_DIR_OOR };
+
+	TEST_ASSERT_EQUAL_INT(1, Test_Feed((const uint8_t *)":OOR:1\r\n", 8, &speed));
+	TEST_ASSERT_EQUAL_INT(1, Test_Feed((const uint8_t *)":OOR:2\r\n", 8, &dir));
+	TEST_ASSERT_EQUAL_INT(0, Test_Feed((const uint8_t *)":OOR:3\r\n", 8, &dir));
+	TEST_ASSERT_EQUAL_INT(0, wrong);
+}
+
+static void test_split_at_every_byte()
+{
+	char msg[32];
+
+	for(size_t k = 0; k <= frameLen; k++) {
+		snprintf(msg, sizeof(msg), "split at byte %u", (unsigned)k);
+		ModbusAscii_Reset(&m);
+		int n = Test_Feed((const uint8_t *)frame, k, &good);
+		n += Test_Feed((const uint8_t *)frame + k, frameLen - k, &good);
+		TEST_ASSERT_EQUAL_INT_MESSAGE(1, n, msg);
+	}
+	TEST_ASSERT_EQUAL_INT(0, wrong);
+}
+
+/* a ':' ends a text line that lost its CR LF, ":OOR:" keeps its own */
+static void test_text_without_crlf()
+{
+	AnemometerSample speed = { 0, 0, 0, ANEMOMETER_SPEED_OOR };
+
+	TEST_ASSERT_EQUAL_INT(0, Test_Feed((const uint8_t *)":HELLO", 6, &good));
+	TEST_ASSERT_EQUAL_INT(1, Test_Feed((const uint8_t *)frame, frameLen, &good));
+	TEST_ASSERT_EQUAL_INT(0, Test_Feed((const uint8_t *)":OOR:2", 6, &good));
+	TEST_ASSERT_EQUAL_INT(1, Test_Feed((const uint8_t *)frame, frameLen, &good));
+	TEST_ASSERT_EQUAL_INT(1, Test_Feed((const uint8_t *)":OO:OOR:1\r\n", 11, &speed));
+	TEST_ASSERT_EQUAL_INT(0, wrong);
+}
+
+/* the tables are constant, a zeroed parser needs no Reset */
+static void test_feed_before_reset()
+{
+	static ModbusAscii fresh;
+
+	for(size_t i = 0; i < frameLen; i++) {
+		ModbusResult r = ModbusAscii_Feed(&fresh, frame[i]);
+		TEST_ASSERT_EQUAL_INT((i == frameLen - 1) ? modbusFrame : modbusNone, r);
+	}
+	TEST_ASSERT_EQUAL_UINT8(9, fresh.len);
+}
+
+/* a flip may still decode ('A' to 'a'), never to another sample, and the next frame gets through */
+static void test_every_bit_flip()
+{
+	char msg[32];
+
+	for(size_t k = 0; k < frameLen; k++) {
+		for(int b = 0; b < 8; b++) {
+			char bad[32];
+			snprintf(msg, sizeof(msg), "bit %d of byte %u", b, (unsigned)k);
+			memcpy(bad, frame, frameLen);
+			bad[k] ^= 1 << b;
+			ModbusAscii_Reset(&m);
+			Test_Feed((const uint8_t *)bad, frameLen, &good);
+			TEST_ASSERT_EQUAL_INT_MESSAGE(0, wrong, msg);
+			TEST_ASSERT_EQUAL_INT_MESSAGE(1, Test_Feed((const uint8_t *)frame, frameLen, &good), msg);
+		}
+	}
+}
+
+/* a good frame after every 16 to 271 bytes of noise, in chunks of 1 to 24 bytes */
+static void test_noise_in_random_chunks()
+{
+	static uint8_t noise[512];
+	uint32_t frames = 0, decoded = 0;
+
+	for(int round = 0; round < 2000; round++) {
+		size_t n = 16 + (Test_Random() & 0xff);
+		for(size_t i = 0; i < n; i++) {
+			uint32_t r = Test_Random();
+			noise[i] = (r & 0x300) ? (uint8_t)r : ":0123456789ABCDEF\r\n"[r % 19]; /* bias to the frame alphabet */
+		}
+		memcpy(&noise[n], frame, frameLen);
+		n += frameLen;
+		frames++;
+
+		for(size_t i = 0; i < n;) {
+			size_t chunk = 1 + Test_Random() % 24;
+			if(chunk > n - i)
+				chunk = n - i;
+			decoded += Test_Feed(&noise[i], chunk, &good);
+			i += chunk;
+		}
+	}
+	TEST_ASSERT_EQUAL_INT(0, wrong);
+	TEST_ASSERT_EQUAL_UINT32(frames, decoded);
+}
+
+int main(int argc, char **argv)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_frame_decodes);
+	RUN_TEST(test_out_of_range_lines);
+	RUN_TEST(test_split_at_every_byte);
+	RUN_TEST(test_text_without_crlf);
+	RUN_TEST(test_feed_before_reset);
+	RUN_TEST(test_every_bit_flip);
+	RUN_TEST(test_noise_in_random_chunks);
+	return UNITY_END();
+}
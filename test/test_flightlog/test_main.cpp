@@ -0,0 +1,143 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "flightlog.h"
+#include "log.h"
+
+/*
+* The recovery of the flight log journal after a power loss. The write of one
+* record is torn at every byte offset in a RAM image of the file: the scan has
+* to find the end, the torn slot has to fail the check and the next append has
+* to land after it.
+*
+* The task writing the log runs against a temporary NATIVE_SD_ROOT where a file
+* takes the place of /f3f: a batch it can not write has to be held and written
+* once the directory is there.
+*/
+#define IMAGE_SLOTS 64
+#define IMAGE_USED  37
+
+typedef struct {
+	FlightRecord slots[IMAGE_SLOTS];
+	uint32_t reads;
+} Image;
+
+static Image image;
+static std::string sdRoot;
+
+static bool Image_Read(uint32_t index, FlightRecord *rec, void *ctx)
+{
+	Image *img = (Image *)ctx;
+
+	img->reads++;
+	memcpy(rec, &img->slots[index], sizeof(FlightRecord));
+	return true;
+}
+
+/* IMAGE_USED good records, the next one torn after len bytes */
+static void Image_Build(uint32_t len)
+{
+	FlightRecord rec;
+
+	memset(image.slots, 0, sizeof(image.slots));
+	for(uint32_t i = 0; i <= IMAGE_USED; i++) {
+		memset(&rec, 0, sizeof(rec));
+		rec.uptime_ms = 1000 * i;
+		rec.total_ms = 40000 + i;
+		rec.legs = FLIGHT_LEGS;
+		FlightLog_Seal(&rec, i);
+		memcpy(&image.slots[i], &rec, (i < IMAGE_USED) ? sizeof(rec) : len);
+	}
+	image.reads = 0;
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_torn_record_at_every_offset()
+{
+	char msg[32];
+
+	for(uint32_t off = 0; off <= sizeof(FlightRecord); off++) {
+		snprintf(msg, sizeof(msg), "torn at byte %u", (unsigned)off);
+		Image_Build(off);
+
+		/* seq is written first and is never 0 for a torn slot, it counts as used */
+		uint32_t used = FlightLog_Scan(Image_Read, &image, IMAGE_SLOTS);
+		TEST_ASSERT_EQUAL_UINT32_MESSAGE(IMAGE_USED + (off > 0 ? 1 : 0), used, msg);
+		TEST_ASSERT_TRUE_MESSAGE(FlightLog_Valid(&image.slots[IMAGE_USED - 1], IMAGE_USED - 1), msg);
+		TEST_ASSERT_EQUAL_MESSAGE(off == sizeof(FlightRecord), FlightLog_Valid(&image.slots[IMAGE_USED], IMAGE_USED), msg);
+
+		FlightRecord rec;
+		memset(&rec, 0, sizeof(rec));
+		FlightLog_Seal(&rec, used);
+		memcpy(&image.slots[used], &rec, sizeof(rec));
+		TEST_ASSERT_EQUAL_UINT32_MESSAGE(used + 1, FlightLog_Scan(Image_Read, &image, IMAGE_SLOTS), msg);
+		TEST_ASSERT_TRUE_MESSAGE(FlightLog_Valid(&image.slots[used], used), msg);
+	}
+}
+
+static void test_scan_reads_log2_slots()
+{
+	Image_Build(sizeof(FlightRecord));
+	FlightLog_Scan(Image_Read, &image, IMAGE_SLOTS);
+	TEST_ASSERT_LESS_OR_EQUAL_UINT32(7, image.reads); /* ceil(log2(64 + 1)) */
+}
+
+static void test_slot_of_another_index_fails()
+{
+	Image_Build(sizeof(FlightRecord));
+	TEST_ASSERT_TRUE(FlightLog_Valid(&image.slots[5], 5));
+	TEST_ASSERT_FALSE(FlightLog_Valid(&image.slots[5], 6));
+	image.slots[5].total_ms ^= 1;
+	TEST_ASSERT_FALSE(FlightLog_Valid(&image.slots[5], 5));
+}
+
+static void test_failed_batch_is_held()
+{
+	FlightRecord rec;
+	std::string dir = sdRoot + "/f3f";
+
+	for(uint32_t i = 0; i < 3; i++) {
+		memset(&rec, 0, sizeof(rec));
+		rec.total_ms = 40000 + i;
+		TEST_ASSERT_TRUE(FlightLog_Append(&rec));
+	}
+	Sim_Run(5000);
+	TEST_ASSERT_EQUAL_UINT32(0, FlightLog_Count());
+
+	TEST_ASSERT_EQUAL_INT(0, unlink(dir.c_str()));
+	TEST_ASSERT_EQUAL_INT(0, mkdir(dir.c_str(), 0755));
+	Sim_Run(5000);
+	TEST_ASSERT_EQUAL_UINT32(3, FlightLog_Count());
+	for(uint32_t i = 0; i < 3; i++) {
+		TEST_ASSERT_TRUE(FlightLog_Read(i, &rec));
+		TEST_ASSERT_EQUAL_UINT32(40000 + i, rec.total_ms);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	char root[] = "/tmp/f3f_flightlog_XXXXXX";
+
+	if(!mkdtemp(root))
+		return 1;
+	sdRoot = root;
+	setenv("NATIVE_SD_ROOT", root, 1);
+	FILE *f = fopen((sdRoot + "/f3f").c_str(), "w"); /* not a directory, the log can not be opened */
+	if(!f)
+		return 1;
+	fclose(f);
+
+	UNITY_BEGIN();
+	Log_Init();
+	FlightLog_Init();
+	Sim_Run(0);
+	RUN_TEST(test_torn_record_at_every_offset);
+	RUN_TEST(test_scan_reads_log2_slots);
+	RUN_TEST(test_slot_of_another_index_fails);
+	RUN_TEST(test_failed_batch_is_held);
+	Sim_Exit(UNITY_END());
+}
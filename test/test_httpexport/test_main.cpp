@@ -0,0 +1,344 @@
+#include <Arduino.h>
+#include <SD.h>
+#include <WebServer.h>
+#include <unity.h>
+#include <string>
+#include "httpexport.h"
+#include "flightlog.h"
+#include "log.h"
+
+/*
+* The CSV and JSON exports over a journal on the host SD (a temporary
+* NATIVE_SD_ROOT) with damaged slots and more records than fit in one chunk.
+* The chunks are drained into a string as the web server sends them: every
+* valid record once, in order, damaged slots left out, the framing whole
+* across the chunk boundaries. Flights appended after HttpExport_Begin() are
+* left for the next export.
+*
+* The requests go through the loopback WebServer of env:native to the server
+* task: the status line, the headers and the chunked framing as the client
+* gets them, and a client that drops in the first chunk.
+*/
+#define TEST_CHUNK   2048   /* HTTP_EXPORT_CHUNK */
+#define TEST_SLOTS   64
+#define TEST_USED    40
+#define TEST_APPENDS 5
+
+static const uint32_t damaged[] = { 3, 17, 25 };
+static const size_t damagedCount = sizeof(damaged) / sizeof(damaged[0]);
+
+static uint32_t chunks;
+
+static bool Test_Damaged(uint32_t seq)
+{
+	for(size_t i = 0; i < damagedCount; i++) {
+		if(damaged[i] == seq)
+			return true;
+	}
+	return false;
+}
+
+static void Test_Record(FlightRecord *rec, uint32_t i)
+{
+	memset(rec, 0, sizeof(*rec));
+	rec->uptime_ms = 1000 * i;
+	rec->total_ms = 40000 + i;
+	rec->mode = i & 1;
+	rec->legs = FLIGHT_LEGS;
+	for(int l = 0; l < FLIGHT_LEGS; l++)
+		rec->split_ms[l] = 4000 * (l + 1) + i;
+	rec->wind_mean = 500 + i;
+	rec->wind_samples = 40;
+}
+
+/* TEST_USED records with the damaged ones flipped or torn, then blank slots */
+static bool Test_WriteJournal()
+{
+	FlightRecord rec;
+
+	SD.mkdir("/f3f");
+	File f = SD.open(FLIGHT_LOG_PATH, FILE_WRITE);
+	if(!f)
+		return false;
+	for(uint32_t i = 0; i < TEST_SLOTS; i++) {
+		memset(&rec, 0, sizeof(rec));
+		if(i < TEST_USED) {
+			Test_Record(&rec, i);
+			FlightLog_Seal(&rec, i);
+		}
+		if(i == damaged[0])
+			rec.total_ms ^= 1 << 7;
+		else if(i == damaged[1])
+			rec.crc ^= 1;
+		else if(i == damaged[2])
+			memset((uint8_t *)&rec + 60, 0, sizeof(rec) - 60);
+		f.write((const uint8_t *)&rec, sizeof(rec));
+	}
+	f.close();
+	return true;
+}
+
+static void Test_Export(ExportFormat format, uint32_t from, ExportCursor *c, std::string *out)
+{
+	static char buf[TEST_CHUNK];
+	size_t n;
+
+	HttpExport_Begin(c, format, from);
+	out->clear();
+	chunks = 0;
+	while((n = HttpExport_Chunk(c, buf, sizeof(buf))) > 0) {
+		TEST_ASSERT_LESS_OR_EQUAL_UINT32(sizeof(buf), n);
+		TEST_ASSERT_LESS_THAN_UINT32(1000, ++chunks);
+		out->append(buf, n);
+	}
+}
+
+static uint32_t Test_Count(const std::string &s, const char *what)
+{
+	uint32_t n = 0;
+
+	for(size_t pos = s.find(what); pos != std::string::npos; pos = s.find(what, pos + 1))
+		n++;
+	return n;
+}
+
+/* the seq of each line or record in order, checked against the log */
+static void Test_Seqs(const std::string &s, const char *prefix, uint32_t from, uint32_t end)
+{
+	char msg[32];
+	size_t pos = 0;
+	uint32_t expect = from;
+
+	for(;;) {
+		while(expect < end && Test_Damaged(expect))
+			expect++;
+		pos = s.find(prefix, pos);
+		if(pos == std::string::npos || pos + strlen(prefix) == s.size())
+			break;
+		pos += strlen(prefix);
+		uint32_t seq = strtoul(s.c_str() + pos, NULL, 10);
+		snprintf(msg, sizeof(msg), "record after %u", (unsigned)expect);
+		TEST_ASSERT_EQUAL_UINT32_MESSAGE(expect, seq, msg);
+		expect++;
+	}
+	TEST_ASSERT_EQUAL_UINT32(end, expect);
+}
+
+/* the body of a chunked response, false without the last chunk or with bytes after it */
+static bool Test_Dechunk(const std::string &s, std::string *body, uint32_t *n)
+{
+	size_t pos = 0;
+
+	body->clear();
+	*n = 0;
+	while(pos < s.size()) {
+		size_t eol = s.find("\r\n", pos);
+		if(eol == std::string::npos)
+			return false;
+		size_t len = strtoul(s.c_str() + pos, NULL, 16);
+		pos = eol + 2;
+		if(s.size() < pos + len + 2 || s.compare(pos + len, 2, "\r\n") != 0)
+			return false;
+		if(len == 0)
+			return pos + 2 == s.size();
+		body->append(s, pos, len);
+		pos += len + 2;
+		(*n)++;
+	}
+	return false;
+}
+
+/* the response to a GET, split at the end of the headers */
+static void Test_Get(const char *uri, size_t dropAfter, std::string *head, std::string *rest)
+{
+	WebServer::nativeServer->nativeRequest(uri, dropAfter);
+	Sim_Run(20); /* the server task polls every 5 ms */
+	std::string r = WebServer::nativeServer->nativeResponse();
+	size_t end = r.find("\r\n\r\n");
+	TEST_ASSERT_TRUE(end != std::string::npos);
+	*head = r.substr(0, end + 4);
+	*rest = r.substr(end + 4);
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_log_has_damaged_slots()
+{
+	FlightRecord rec;
+
+	TEST_ASSERT_EQUAL_UINT32(TEST_USED, FlightLog_Count());
+	for(size_t i = 0; i < damagedCount; i++)
+		TEST_ASSERT_FALSE(FlightLog_Read(damaged[i], &rec));
+	TEST_ASSERT_TRUE(FlightLog_Read(TEST_USED - 1, &rec));
+}
+
+static void test_csv()
+{
+	ExportCursor c;
+	std::string s;
+
+	Test_Export(exportCsv, 0, &c, &s);
+
+	TEST_ASSERT_GREATER_THAN_UINT32(1, chunks);
+	TEST_ASSERT_EQUAL_UINT32(0, s.find("seq,epoch,uptime_ms,mode,total_ms,legs,flags,split1_ms,"));
+	TEST_ASSERT_EQUAL_UINT32(TEST_USED - damagedCount + 1, Test_Count(s, "\r\n"));
+	TEST_ASSERT_EQUAL_UINT32(TEST_USED - damagedCount, c.records);
+	TEST_ASSERT_EQUAL_STRING("\r\n", s.c_str() + s.size() - 2);
+	TEST_ASSERT_EQUAL_UINT32(0, Test_Count(s, "\n\n"));
+	TEST_ASSERT_TRUE(s.find("\r\n0,0,0,competition,40000,10,0,4000,8000,") != std::string::npos);
+	TEST_ASSERT_TRUE(s.find("\r\n1,0,1000,training,40001,10,0,4001,8001,") != std::string::npos);
+	Test_Seqs(s, "\r\n", 0, TEST_USED);
+}
+
+static void test_json()
+{
+	ExportCursor c;
+	std::string s;
+	uint32_t records = TEST_USED - damagedCount;
+
+	Test_Export(exportJson, 0, &c, &s);
+
+	TEST_ASSERT_GREATER_THAN_UINT32(1, chunks);
+	TEST_ASSERT_EQUAL_UINT32(0, s.find("[\n{\"seq\":0,"));
+	TEST_ASSERT_EQUAL_STRING("}\n]\n", s.c_str() + s.size() - 4);
+	TEST_ASSERT_EQUAL_UINT32(records, Test_Count(s, "\n{\"seq\":"));
+	TEST_ASSERT_EQUAL_UINT32(records - 1, Test_Count(s, "},\n{\"seq\":"));
+	TEST_ASSERT_EQUAL_UINT32(0, Test_Count(s, ",\n]"));
+	TEST_ASSERT_EQUAL_UINT32(records, c.records);
+	TEST_ASSERT_EQUAL_UINT32(records, Test_Count(s, "\"split_ms\":[4"));
+	TEST_ASSERT_EQUAL_UINT32(records + 1, Test_Count(s, "["));
+	TEST_ASSERT_EQUAL_UINT32(records + 1, Test_Count(s, "]"));
+	TEST_ASSERT_EQUAL_UINT32(Test_Count(s, "{"), Test_Count(s, "}"));
+	Test_Seqs(s, "\n{\"seq\":", 0, TEST_USED);
+}
+
+/* the first valid record after from has no comma, even past a damaged slot */
+static void test_from()
+{
+	ExportCursor c;
+	std::string s;
+
+	Test_Export(exportJson, damaged[1], &c, &s);
+
+	TEST_ASSERT_EQUAL_UINT32(0, s.find("[\n{\"seq\":18,"));
+	Test_Seqs(s, "\n{\"seq\":", damaged[1], TEST_USED);
+
+	Test_Export(exportCsv, TEST_USED, &c, &s);
+	TEST_ASSERT_EQUAL_UINT32(1, Test_Count(s, "\r\n"));
+	Test_Export(exportJson, TEST_USED, &c, &s);
+	TEST_ASSERT_EQUAL_STRING("[\n]\n", s.c_str());
+}
+
+/* flights logged while an export runs are not part of it */
+static void test_end_fixed_at_begin()
+{
+	static char buf[TEST_CHUNK];
+	ExportCursor c;
+	FlightRecord rec;
+	std::string s;
+	size_t n;
+
+	HttpExport_Begin(&c, exportJson, 0);
+	TEST_ASSERT_EQUAL_UINT32(TEST_USED, c.end);
+	n = HttpExport_Chunk(&c, buf, sizeof(buf));
+	s.append(buf, n);
+
+	for(uint32_t i = 0; i < TEST_APPENDS; i++) {
+		Test_Record(&rec, TEST_USED + i);
+		TEST_ASSERT_TRUE(FlightLog_Append(&rec));
+	}
+	Sim_Run(100); /* the flight log task writes them */
+	TEST_ASSERT_EQUAL_UINT32(TEST_USED + TEST_APPENDS, FlightLog_Count());
+
+	while((n = HttpExport_Chunk(&c, buf, sizeof(buf))) > 0)
+		s.append(buf, n);
+	TEST_ASSERT_EQUAL_UINT32(TEST_USED, c.end);
+	TEST_ASSERT_EQUAL_STRING("}\n]\n", s.c_str() + s.size() - 4);
+	Test_Seqs(s, "\n{\"seq\":", 0, TEST_USED);
+
+	Test_Export(exportJson, 0, &c, &s);
+	Test_Seqs(s, "\n{\"seq\":", 0, TEST_USED + TEST_APPENDS);
+}
+
+static void test_http_chunked_response()
+{
+	ExportCursor c;
+	std::string expect, head, rest, body;
+	uint32_t n;
+
+	Test_Export(exportJson, 0, &c, &expect);
+	Test_Get("/flights.json", (size_t)-1, &head, &rest);
+	TEST_ASSERT_EQUAL_STRING("HTTP/1.1 200 OK\r\n"
+		"Content-Type: application/json\r\n"
+		"Content-Disposition: attachment; filename=flights.json\r\n"
+		"Accept-Ranges: none\r\n"
+		"Transfer-Encoding: chunked\r\n"
+		"Connection: close\r\n\r\n", head.c_str());
+	TEST_ASSERT_TRUE(Test_Dechunk(rest, &body, &n));
+	TEST_ASSERT_EQUAL_UINT32(chunks, n);
+	TEST_ASSERT_GREATER_THAN_UINT32(1, n);
+	TEST_ASSERT_EQUAL_STRING(expect.c_str(), body.c_str());
+	TEST_ASSERT_EQUAL_STRING("0\r\n\r\n", rest.c_str() + rest.size() - 5);
+}
+
+static void test_http_from_arg()
+{
+	ExportCursor c;
+	std::string expect, head, rest, body;
+	uint32_t n;
+
+	Test_Export(exportCsv, damaged[1], &c, &expect);
+	Test_Get("/flights.csv?from=17", (size_t)-1, &head, &rest);
+	TEST_ASSERT_EQUAL_UINT32(0, head.find("HTTP/1.1 200 OK\r\nContent-Type: text/csv\r\n"));
+	TEST_ASSERT_TRUE(head.find("filename=flights.csv\r\n") != std::string::npos);
+	TEST_ASSERT_TRUE(Test_Dechunk(rest, &body, &n));
+	TEST_ASSERT_EQUAL_STRING(expect.c_str(), body.c_str());
+}
+
+/* the export stops after the chunk the client dropped in, the server serves the next request */
+static void test_http_client_drops()
+{
+	std::string head, rest, body;
+	uint32_t n;
+
+	Test_Get("/flights.json", (size_t)-1, &head, &rest);
+	size_t full = WebServer::nativeServer->nativeOffered();
+	size_t drop = head.size() + 100;
+
+	Test_Get("/flights.json", drop, &head, &rest);
+	TEST_ASSERT_EQUAL_UINT32(drop, head.size() + rest.size());
+	TEST_ASSERT_FALSE(Test_Dechunk(rest, &body, &n));
+	/* the header, one chunk with its framing and the last chunk, no second chunk */
+	TEST_ASSERT_LESS_OR_EQUAL_UINT32(head.size() + TEST_CHUNK + 16, WebServer::nativeServer->nativeOffered());
+	TEST_ASSERT_GREATER_THAN_UINT32(head.size() + TEST_CHUNK + 16, full);
+
+	Test_Get("/flights.json", (size_t)-1, &head, &rest);
+	TEST_ASSERT_TRUE(Test_Dechunk(rest, &body, &n));
+}
+
+int main(int argc, char **argv)
+{
+	char root[] = "/tmp/f3f_httpexport_XXXXXX";
+
+	if(!mkdtemp(root))
+		return 1;
+	setenv("NATIVE_SD_ROOT", root, 1);
+	if(!Test_WriteJournal())
+		return 1;
+
+	UNITY_BEGIN();
+	Log_Init();
+	FlightLog_Init();
+	HttpExport_Init();
+	Sim_Run(0);
+	RUN_TEST(test_log_has_damaged_slots);
+	RUN_TEST(test_csv);
+	RUN_TEST(test_json);
+	RUN_TEST(test_from);
+	RUN_TEST(test_http_chunked_response);
+	RUN_TEST(test_http_from_arg);
+	RUN_TEST(test_http_client_drops);
+	RUN_TEST(test_end_fixed_at_begin);
+	Sim_Exit(UNITY_END());
+}